@@ -0,0 +1,373 @@
+/**
+ *   Histograms of per-state features over a stream of states.
+ *
+ *   Features, computed directly from the components:
+ *
+ *      flip     number of flipped edges (popcount of eoMask)
+ *      twist    number of twisted corners
+ *      solved   number of edges and corners in place and oriented
+ *      parity   edge and corner permutation parity
+ *      codist   moves needed to fix the corner orientation
+ *      eodist   moves needed to fix the edge orientation
+ *      pdb      the larger of codist and eodist; a lower bound on
+ *               the distance to solved
+ *
+ *   The two distances come from small pattern databases built by
+ *   breadth-first search over the orientation masks at startup.
+ *   Input is read a batch at a time and split among threads, each
+ *   with its own histogram; the histograms are merged at the end.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubecoords.h"
+#include "moves.h"
+#include "parsestate.h"
+#include "batch.h"
+#include "aggregate.h"
+#include "errors.h"
+#define FLIP 0
+#define TWIST 1
+#define SOLVED 2
+#define PARITY 3
+#define CODIST 4
+#define EODIST 5
+#define PDB 6
+#define UNREACHABLE 255
+static const char *featureNames[AGG_FEATURES] = {
+   "flip", "twist", "solved", "parity", "codist", "eodist", "pdb" } ;
+static const char *parityNames[] = {
+   "even-even", "even-odd", "odd-even", "odd-odd" } ;
+static unsigned char twistCount[6561] ;
+static unsigned char untwisted[6561] ;  // bit 7-i set if corner i is 0
+static unsigned char coDist[6561] ;
+static unsigned char eoDist[4096] ;
+static void coToCubies(int co, struct cubies *cu) {
+   for (int i=0; i<12; i++)
+      cu->e[i] = 2*i ;
+   for (int i=7; i>=0; i--) {
+      cu->c[i] = 4*i + co % 3 ;
+      co /= 3 ;
+   }
+}
+static void eoToCubies(int eo, struct cubies *cu) {
+   for (int i=0; i<12; i++)
+      cu->e[i] = 2*i + (1 & (eo >> (11-i))) ;
+   for (int i=0; i<8; i++)
+      cu->c[i] = 4*i ;
+}
+static int cubiesCo(const struct cubies *cu) {
+   int co = 0 ;
+   for (int i=0; i<8; i++)
+      co = 3 * co + (cu->c[i] & 3) ;
+   return co ;
+}
+static int cubiesEo(const struct cubies *cu) {
+   int eo = 0 ;
+   for (int i=0; i<12; i++)
+      eo = 2 * eo + (cu->e[i] & 1) ;
+   return eo ;
+}
+/*
+ *   Breadth-first search from solved over n orientation states;
+ *   orientation after a move does not depend on which cubies are
+ *   where, so identity permutations are fine.
+ */
+static void bfs(unsigned char *dist, int n, void (*tocubies)(int, struct cubies *),
+                int (*fromcubies)(const struct cubies *)) {
+   memset(dist, UNREACHABLE, n) ;
+   dist[0] = 0 ;
+   for (int d=0, found=1; found; d++) {
+      found = 0 ;
+      for (int s=0; s<n; s++)
+         if (dist[s] == d)
+            for (int mv=0; mv<18; mv++) {
+               struct cubies cu ;
+               tocubies(s, &cu) ;
+               domoveCubies(&cu, mv) ;
+               int t = fromcubies(&cu) ;
+               if (dist[t] == UNREACHABLE) {
+                  dist[t] = d + 1 ;
+                  found = 1 ;
+               }
+            }
+   }
+}
+static int inited ;
+/*
+ *   Build the tables; call before using aggAdd from several threads.
+ */
+void aggInit() {
+   if (inited)
+      return ;
+   initmoves() ;
+   for (int co=0; co<6561; co++) {
+      int n = 0 ;
+      for (int v=co; v; v /= 3)
+         n += (v % 3) != 0 ;
+      twistCount[co] = n ;
+      untwisted[co] = 0 ;
+      for (int i=7, v=co; i>=0; i--, v /= 3)
+         untwisted[co] |= (v % 3 == 0) << (7 - i) ;
+   }
+   bfs(coDist, 6561, coToCubies, cubiesCo) ;
+   bfs(eoDist, 4096, eoToCubies, cubiesEo) ;
+   inited = 1 ;
+}
+/*
+ *   Parse a comma separated list of feature names; "all" or an empty
+ *   list is everything.  Return a bit mask or an error.
+ */
+int aggFeatureMask(const char *names) {
+   int mask = 0 ;
+   if (*names == 0)
+      return (1 << AGG_FEATURES) - 1 ;
+   while (*names) {
+      int len = strcspn(names, ",") ;
+      int f = -1 ;
+      for (int i=0; i<AGG_FEATURES; i++)
+         if ((int)strlen(featureNames[i]) == len &&
+             strncmp(names, featureNames[i], len) == 0)
+            f = i ;
+      if (len == 3 && strncmp(names, "all", 3) == 0)
+         mask = (1 << AGG_FEATURES) - 1 ;
+      else if (f < 0)
+         return BAD_FEATURE_NAME ;
+      else
+         mask |= 1 << f ;
+      names += len ;
+      if (*names == ',')
+         names++ ;
+   }
+   return mask ;
+}
+/*
+ *   Parity of a permutation from its rank:  the sum of the Lehmer
+ *   digits, which are the mixed radix digits of the rank.
+ */
+static int lexParity(int lex, int n) {
+   int p = 0 ;
+   for (int i=2; i<=n && lex; i++) {
+      p += lex % i ;
+      lex /= i ;
+   }
+   return p & 1 ;
+}
+/*
+ *   Bit n-1-i set if the permutation with this rank has i in place i,
+ *   without unranking it.  The Lehmer digits come off the rank with
+ *   constant divisors, and the values not yet used are kept as the
+ *   nibbles of a 64-bit word, so taking the d'th is a shift and mask
+ *   instead of the quadratic fix-up in decodePerm.
+ */
+static inline int fixedMask(int lex, const int n) {
+   unsigned char d[12] ;
+   for (int i=n-1, r=1; i>=0; i--, r++) {
+      d[i] = lex % r ;
+      lex /= r ;
+   }
+   unsigned long long left = 0xba9876543210ULL ;
+   int mask = 0 ;
+   for (int i=0; i<n; i++) {
+      int s = 4 * d[i] ;
+      int v = (left >> s) & 15 ;
+      left = (left & ((1ULL << s) - 1)) | ((left >> (s + 4)) << s) ;
+      mask |= (v == i) << (n - 1 - i) ;
+   }
+   return mask ;
+}
+/*
+ *   Edges and corners in place and oriented; the masks line up with
+ *   the bits of eoMask and the untwisted table.
+ */
+static int solvedCubies(int epLex, int eoMask, int cpLex, int coMask) {
+   int n = 0 ;
+   for (int m=fixedMask(epLex, 12) & ~eoMask; m; m &= m-1)
+      n++ ;
+   for (int m=fixedMask(cpLex, 8) & untwisted[coMask]; m; m &= m-1)
+      n++ ;
+   return n ;
+}
+static int distBin(int d) {
+   return d == UNREACHABLE ? AGG_MAXBINS-1 : d ;
+}
+/*
+ *   Add n states, given as columns, to the histogram.
+ */
+void aggAdd(struct aggHistogram *h, int features, const int *epLex,
+            const int *eoMask, const int *cpLex, const int *coMask, int n) {
+   h->count += n ;
+   for (int i=0; i<n; i++) {
+      if (features & (1 << FLIP)) {
+         int f = 0 ;
+         for (int m=eoMask[i]; m; m &= m-1)
+            f++ ;
+         h->bins[FLIP][f]++ ;
+      }
+      if (features & (1 << TWIST))
+         h->bins[TWIST][twistCount[coMask[i]]]++ ;
+      if (features & (1 << SOLVED))
+         h->bins[SOLVED][solvedCubies(epLex[i], eoMask[i], cpLex[i],
+                                      coMask[i])]++ ;
+      if (features & (1 << PARITY))
+         h->bins[PARITY][2 * lexParity(epLex[i], 12) +
+                         lexParity(cpLex[i], 8)]++ ;
+      if (features & (1 << CODIST))
+         h->bins[CODIST][distBin(coDist[coMask[i]])]++ ;
+      if (features & (1 << EODIST))
+         h->bins[EODIST][distBin(eoDist[eoMask[i]])]++ ;
+      if (features & (1 << PDB)) {
+         int d = coDist[coMask[i]] ;
+         if (eoDist[eoMask[i]] > d)
+            d = eoDist[eoMask[i]] ;
+         h->bins[PDB][distBin(d)]++ ;
+      }
+   }
+}
+void aggMerge(struct aggHistogram *into, const struct aggHistogram *from) {
+   into->count += from->count ;
+   for (int f=0; f<AGG_FEATURES; f++)
+      for (int b=0; b<AGG_MAXBINS; b++)
+         into->bins[f][b] += from->bins[f][b] ;
+}
+/*
+ *   One line per nonempty bin:  feature, value, count.
+ */
+void aggPrint(FILE *out, const struct aggHistogram *h, int features) {
+   fprintf(out, "states %lld\n", h->count) ;
+   for (int f=0; f<AGG_FEATURES; f++)
+      if (features & (1 << f))
+         for (int b=0; b<AGG_MAXBINS; b++)
+            if (h->bins[f][b]) {
+               if (f == PARITY)
+                  fprintf(out, "%s %s", featureNames[f], parityNames[b]) ;
+               else if (f >= CODIST && b == AGG_MAXBINS-1)
+                  fprintf(out, "%s unreachable", featureNames[f]) ;
+               else
+                  fprintf(out, "%s %d", featureNames[f], b) ;
+               fprintf(out, " %lld\n", h->bins[f][b]) ;
+            }
+}
+/*
+ *   Batch of input shared by the threads:  either text lines, or
+ *   packed 11-byte records.  Each thread has its own histogram.
+ */
+#define CHUNK 1024
+struct aggWorker {
+   int err ;
+   struct aggHistogram h ;
+   int cols[4][CHUNK] ;
+   unsigned char errbits[CHUNK/8] ;
+} ;
+struct aggJob {
+   int packed ;
+   int features ;
+   struct lineBatch lines ;
+   unsigned char *records ;
+   int n ;
+   struct aggWorker *w ;
+} ;
+static void aggSlice(void *arg, int t, int nt) {
+   struct aggJob *job = arg ;
+   struct aggWorker *w = &job->w[t] ;
+   int lo = (long long)job->n * t / nt ;
+   int hi = (long long)job->n * (t + 1) / nt ;
+   while (lo < hi && w->err == 0) {
+      int k = hi - lo < CHUNK ? hi - lo : CHUNK ;
+      int m = 0 ;
+      if (job->packed) {
+         const unsigned char *p = job->records + 11 * lo ;
+         if (frombytes11Bulk(p, k, w->cols[0], w->cols[1], w->cols[2],
+                             w->cols[3], w->errbits) != 0) {
+            // rerun the first bad record alone for its error code
+            struct cubecoords cc ;
+            int i = 0 ;
+            while (!((w->errbits[i>>3] >> (i & 7)) & 1))
+               i++ ;
+            w->err = frombytes11(p + 11 * i, &cc) ;
+         }
+         m = k ;
+      } else {
+         for (int i=lo; i<lo+k && w->err == 0; i++) {
+            const char *line = job->lines.arena + job->lines.start[i] ;
+            struct cubies cu ;
+            struct cubecoords cc ;
+            int havecubies ;
+            if (line[strspn(line, " \t\r\n")] == 0) // skip blank lines
+               continue ;
+            w->err = job->lines.status[i] ;
+            if (w->err == 0)
+               w->err = parseState(line, &cu, &cc, &havecubies) ;
+            if (w->err == 0 && havecubies)
+               w->err = cubiesToComponents(&cu, &cc) ;
+            w->cols[0][m] = cc.epLex ;
+            w->cols[1][m] = cc.eoMask ;
+            w->cols[2][m] = cc.cpLex ;
+            w->cols[3][m] = cc.coMask ;
+            m++ ;
+         }
+      }
+      if (w->err == 0)
+         aggAdd(&w->h, job->features, w->cols[0], w->cols[1], w->cols[2],
+                w->cols[3], m) ;
+      lo += k ;
+   }
+}
+static int readRecords(FILE *in, struct aggJob *job) {
+   size_t got = fread(job->records, 1, 11 * BATCH_LINES, in) ;
+   if (ferror(in))
+      return IO_ERROR ;
+   if (got % 11) // a partial record at the end
+      return PARTIAL_RECORD ;
+   job->n = got / 11 ;
+   return 0 ;
+}
+/*
+ *   Read states (text lines, or packed 11-byte records), and print
+ *   the histograms of the selected features.
+ */
+int aggregateStates(FILE *in, FILE *out, int features, int packed,
+                    int nthreads) {
+   nthreads = threadCount(nthreads) ;
+   aggInit() ;
+   struct aggJob job ;
+   int err = 0 ;
+   job.packed = packed ;
+   job.features = features ;
+   job.records = 0 ;
+   job.lines.arena = 0 ;
+   job.lines.start = job.lines.status = 0 ;
+   if (packed)
+      job.records = malloc(11 * BATCH_LINES) ;
+   else
+      err = lineBatchInit(&job.lines) ;
+   job.w = calloc(nthreads, sizeof(*job.w)) ;
+   if (err == 0 && (job.w == 0 || (packed && job.records == 0)))
+      err = OUT_OF_MEMORY ;
+   while (err == 0) {
+      if (packed) {
+         err = readRecords(in, &job) ;
+      } else {
+         err = lineBatchRead(in, &job.lines) ;
+         job.n = job.lines.n ;
+      }
+      if (err || job.n == 0)
+         break ;
+      int nt = job.n < CHUNK ? 1 : nthreads ;
+      runThreads(nt, aggSlice, &job) ;
+      for (int t=0; t<nt; t++)
+         if (job.w[t].err)
+            err = job.w[t].err ;
+   }
+   if (err == 0) {
+      for (int t=1; t<nthreads; t++)
+         aggMerge(&job.w[0].h, &job.w[t].h) ;
+      aggPrint(out, &job.w[0].h, features) ;
+      if (fflush(out) != 0)
+         err = IO_ERROR ;
+   }
+   lineBatchFree(&job.lines) ;
+   free(job.records) ;
+   free(job.w) ;
+   return err ;
+}
@@ -0,0 +1,23 @@
+/*
+ *   Routines exported.
+ */
+#ifndef AGGREGATE_H
+#include <stdio.h>
+#define AGG_FEATURES 7
+#define AGG_MAXBINS 21
+struct aggHistogram {
+   long long count ;
+   long long bins[AGG_FEATURES][AGG_MAXBINS] ;
+} ;
+extern void aggInit() ;
+extern int aggFeatureMask(const char *names) ;
+extern void aggAdd(struct aggHistogram *h, int features, const int *epLex,
+                   const int *eoMask, const int *cpLex, const int *coMask,
+                   int n) ;
+extern void aggMerge(struct aggHistogram *into,
+                     const struct aggHistogram *from) ;
+extern void aggPrint(FILE *out, const struct aggHistogram *h, int features) ;
+extern int aggregateStates(FILE *in, FILE *out, int features, int packed,
+                           int nthreads) ;
+#define AGGREGATE_H
+#endif
@@ -0,0 +1,109 @@
+/**
+ *   The scaffolding shared by the bulk modes:  choosing a thread
+ *   count, running a function on that many threads, and reading
+ *   text input a batch of lines at a time.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "batch.h"
+#include "errors.h"
+#define MAXTHREADS 256
+#define ARENASZ (BATCH_LINES * 64)
+/*
+ *   The number of threads to use for a request of nthreads; 0 or
+ *   less means one per CPU.
+ */
+int threadCount(int nthreads) {
+   if (nthreads <= 0)
+      nthreads = sysconf(_SC_NPROCESSORS_ONLN) ;
+   if (nthreads <= 0)
+      nthreads = 1 ;
+   if (nthreads > MAXTHREADS)
+      nthreads = MAXTHREADS ;
+   return nthreads ;
+}
+struct threadArg {
+   void (*f)(void *, int, int) ;
+   void *arg ;
+   int t ;
+   int nt ;
+} ;
+static void *threadMain(void *p) {
+   struct threadArg *a = p ;
+   a->f(a->arg, a->t, a->nt) ;
+   return 0 ;
+}
+/*
+ *   Call f(arg, t, nt) for t from 0 to nt-1, each on its own thread,
+ *   and wait for all of them.  The calling thread does t = 0, and any
+ *   thread that cannot be created is run inline instead.
+ */
+void runThreads(int nthreads, void (*f)(void *arg, int t, int nt),
+                void *arg) {
+   pthread_t tid[MAXTHREADS] ;
+   struct threadArg a[MAXTHREADS] ;
+   if (nthreads < 1)
+      nthreads = 1 ;
+   if (nthreads > MAXTHREADS)
+      nthreads = MAXTHREADS ;
+   for (int t=0; t<nthreads; t++) {
+      a[t].f = f ;
+      a[t].arg = arg ;
+      a[t].t = t ;
+      a[t].nt = nthreads ;
+      if (t == 0 || pthread_create(&tid[t], 0, threadMain, &a[t]) != 0)
+         tid[t] = 0 ;
+   }
+   f(arg, 0, nthreads) ;
+   for (int t=1; t<nthreads; t++)
+      if (tid[t])
+         pthread_join(tid[t], 0) ;
+      else
+         f(arg, t, nthreads) ;
+}
+int lineBatchInit(struct lineBatch *b) {
+   b->arena = malloc(ARENASZ) ;
+   b->start = malloc(BATCH_LINES * sizeof(int)) ;
+   b->status = malloc(BATCH_LINES * sizeof(int)) ;
+   b->n = 0 ;
+   if (b->arena && b->start && b->status)
+      return 0 ;
+   lineBatchFree(b) ;
+   return OUT_OF_MEMORY ;
+}
+/*
+ *   Read the next batch of lines; b->n is 0 at the end of the input.
+ */
+int lineBatchRead(FILE *in, struct lineBatch *b) {
+   int used = 0 ;
+   b->n = 0 ;
+   while (b->n < BATCH_LINES && used + BATCH_LINESZ <= ARENASZ) {
+      char *p = b->arena + used ;
+      if (fgets(p, BATCH_LINESZ, in) == 0)
+         break ;
+      int len = strlen(p) ;
+      b->status[b->n] = 0 ;
+      if (len == BATCH_LINESZ-1 && p[len-1] != '\n') {
+         int c = getc(in) ; // a newline or the end here means it fit
+         if (c != EOF && c != '\n') {
+            while ((c = getc(in)) != EOF && c != '\n')
+               ;
+            b->status[b->n] = LINE_TOO_LONG ;
+         }
+      }
+      b->start[b->n++] = used ;
+      used += len + 1 ;
+   }
+   return ferror(in) ? IO_ERROR : 0 ;
+}
+void lineBatchFree(struct lineBatch *b) {
+   free(b->arena) ;
+   free(b->start) ;
+   free(b->status) ;
+   b->arena = 0 ;
+   b->start = 0 ;
+   b->status = 0 ;
+}
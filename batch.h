@@ -0,0 +1,27 @@
+/*
+ *   Routines exported.
+ */
+#ifndef BATCH_H
+#include <stdio.h>
+#define BATCH_LINESZ 2048
+#define BATCH_LINES 65536
+/*
+ *   A batch of input lines, each kept with its newline in one arena.
+ *   A line too long for BATCH_LINESZ is cut short, the rest of it
+ *   skipped, and its status set to LINE_TOO_LONG; otherwise status
+ *   is 0.
+ */
+struct lineBatch {
+   char *arena ;
+   int *start ;                /* offset of each line in the arena */
+   int *status ;
+   int n ;
+} ;
+extern int threadCount(int nthreads) ;
+extern void runThreads(int nthreads, void (*f)(void *arg, int t, int nt),
+                       void *arg) ;
+extern int lineBatchInit(struct lineBatch *b) ;
+extern int lineBatchRead(FILE *in, struct lineBatch *b) ;
+extern void lineBatchFree(struct lineBatch *b) ;
+#define BATCH_H
+#endif
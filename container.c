@@ -0,0 +1,388 @@
+/**
+ *   Columnar container for large collections of states.
+ *
+ *   States are stored in blocks of up to CC_BLOCK, one column per
+ *   component.  Each column of a block is stored either as offsets
+ *   from the block minimum or, when the column never decreases (as
+ *   epLex does in a sorted collection), as differences from the value
+ *   before; whichever needs fewer bits.  The values are bit packed at
+ *   that width, low bits first, so a value is one unaligned 64-bit
+ *   load, a shift, and a mask.
+ *
+ *   File layout (all integers little-endian):
+ *
+ *      "CC3C" version(4) blocksize(4)
+ *      blocks:
+ *         count(4)
+ *         per column:  min(4) max(4) width(1) mode(1) unused(2)
+ *         payload bytes(4) payload
+ *      count(4) = 0, ending the blocks
+ *      index, per block:  offset(8) count(4) per column min(4) max(4)
+ *      index offset(8) block count(4) "CC3X"
+ *
+ *   The blocks can be read as a stream; the index at the end allows
+ *   seeking to any block and skipping blocks by their min and max.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubecoords.h"
+#include "container.h"
+#include "errors.h"
+#define CC_VERSION 1
+#define MODE_OFFSET 0
+#define MODE_DELTA 1
+#define HEADERSZ 12
+#define BLOCKHEADERSZ (4 + 12 * CC_COLUMNS + 4)
+#define INDEXENTRYSZ (12 + 8 * CC_COLUMNS)
+#define TRAILERSZ 16
+static const int columnLimit[CC_COLUMNS] = { 479001600, 4096, 40320, 6561 } ;
+static void put32(unsigned char *p, unsigned int v) {
+   for (int i=0; i<4; i++, v >>= 8)
+      p[i] = v ;
+}
+static void put64(unsigned char *p, unsigned long long v) {
+   for (int i=0; i<8; i++, v >>= 8)
+      p[i] = v ;
+}
+static unsigned int get32(const unsigned char *p) {
+   return p[0] + (p[1] << 8) + (p[2] << 16) + ((unsigned int)p[3] << 24) ;
+}
+static unsigned long long get64(const unsigned char *p) {
+   return get32(p) + ((unsigned long long)get32(p+4) << 32) ;
+}
+static unsigned long long load64le(const unsigned char *p) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   unsigned long long v ;
+   memcpy(&v, p, 8) ;
+   return v ;
+#else
+   return get64(p) ;
+#endif
+}
+static int bitsFor(unsigned int v) {
+   int b = 0 ;
+   while (v >> b)
+      b++ ;
+   return b ;
+}
+/*
+ *   Pack n values of w bits; return the bytes written.
+ */
+static int packBits(const unsigned int *v, int n, int w, unsigned char *out) {
+   unsigned char *p = out ;
+   unsigned long long acc = 0 ;
+   int nb = 0 ;
+   for (int i=0; i<n; i++) {
+      acc |= (unsigned long long)v[i] << nb ;
+      nb += w ;
+      while (nb >= 8) {
+         *p++ = acc ;
+         acc >>= 8 ;
+         nb -= 8 ;
+      }
+   }
+   if (nb > 0)
+      *p++ = acc ;
+   return p - out ;
+}
+/*
+ *   Unpack n values of a width known at compile time.  Eight values
+ *   take exactly w bytes, so within each group of eight every load
+ *   offset and shift is a constant and the compiler can unroll and
+ *   vectorize the loop.  The input must be followed by at least 8
+ *   readable bytes.  Return nonzero if a value exceeds max.
+ */
+#ifdef __GNUC__
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE inline
+#endif
+static ALWAYS_INLINE int unpackFixed(const unsigned char *in, int n,
+                                     const int w, int base, int max,
+                                     int *out) {
+   const unsigned long long mask = (1ULL << w) - 1 ;
+   int bad = 0 ;
+   int i = 0 ;
+   for (const unsigned char *p = in; i+8<=n; i+=8, p+=w)
+      for (int j=0; j<8; j++) {
+         int v = base + (int)((load64le(p + ((j*w) >> 3)) >> ((j*w) & 7)) &
+                              mask) ;
+         out[i+j] = v ;
+         bad |= v > max ;
+      }
+   for (unsigned int bit=i*w; i<n; i++, bit += w) {
+      int v = base + (int)((load64le(in + (bit >> 3)) >> (bit & 7)) & mask) ;
+      out[i] = v ;
+      bad |= v > max ;
+   }
+   return bad ;
+}
+#define UNPACK(w) case w: return unpackFixed(in, n, w, base, max, out) ;
+static int unpackOffsets(const unsigned char *in, int n, int w, int base,
+                         int max, int *out) {
+   switch (w) {
+      UNPACK(0) UNPACK(1) UNPACK(2) UNPACK(3) UNPACK(4) UNPACK(5)
+      UNPACK(6) UNPACK(7) UNPACK(8) UNPACK(9) UNPACK(10) UNPACK(11)
+      UNPACK(12) UNPACK(13) UNPACK(14) UNPACK(15) UNPACK(16) UNPACK(17)
+      UNPACK(18) UNPACK(19) UNPACK(20) UNPACK(21) UNPACK(22) UNPACK(23)
+      UNPACK(24) UNPACK(25) UNPACK(26) UNPACK(27) UNPACK(28) UNPACK(29)
+   }
+   return 1 ;
+}
+static int unpackBits(const unsigned char *in, int n, int w, int mode,
+                      int base, int max, int *out) {
+   if (mode == MODE_OFFSET)
+      return unpackOffsets(in, n, w, base, max, out) ;
+   unpackOffsets(in, n, w, 0, 1 << 30, out) ;
+   // 64 bits so a corrupt block cannot overflow; the sum never
+   // decreases, so only the last value needs checking against max
+   long long v = base ;
+   for (int i=0; i<n; i++) {
+      v += out[i] ;
+      out[i] = (int)(v & 0x7fffffff) ;
+   }
+   return n > 0 && v > max ;
+}
+int ccWriterOpen(struct ccWriter *w, FILE *f) {
+   unsigned char h[HEADERSZ] ;
+   w->f = f ;
+   w->n = 0 ;
+   w->index = 0 ;
+   w->nblocks = w->maxblocks = 0 ;
+   memcpy(h, "CC3C", 4) ;
+   put32(h+4, CC_VERSION) ;
+   put32(h+8, CC_BLOCK) ;
+   if (fwrite(h, 1, HEADERSZ, f) != HEADERSZ)
+      return IO_ERROR ;
+   w->offset = HEADERSZ ;
+   return 0 ;
+}
+static int flushBlock(struct ccWriter *w) {
+   unsigned int v[CC_BLOCK] ;
+   unsigned char *buf = w->out ;
+   int n = w->n ;
+   if (n == 0)
+      return 0 ;
+   if (w->nblocks == w->maxblocks) {
+      int m = w->maxblocks ? 2 * w->maxblocks : 64 ;
+      struct ccBlockInfo *t = realloc(w->index, m * sizeof(*t)) ;
+      if (t == 0)
+         return OUT_OF_MEMORY ;
+      w->index = t ;
+      w->maxblocks = m ;
+   }
+   struct ccBlockInfo *bi = &w->index[w->nblocks] ;
+   bi->offset = w->offset ;
+   bi->count = n ;
+   put32(buf, n) ;
+   int len = BLOCKHEADERSZ ;
+   for (int c=0; c<CC_COLUMNS; c++) {
+      const int *col = w->col[c] ;
+      int lo = col[0], hi = col[0], maxstep = 0, sorted = 1 ;
+      for (int i=1; i<n; i++) {
+         if (col[i] < lo)
+            lo = col[i] ;
+         if (col[i] > hi)
+            hi = col[i] ;
+         if (col[i] < col[i-1])
+            sorted = 0 ;
+         else if (col[i] - col[i-1] > maxstep)
+            maxstep = col[i] - col[i-1] ;
+      }
+      int width = bitsFor(hi - lo) ;
+      int mode = MODE_OFFSET ;
+      if (sorted && bitsFor(maxstep) < width) {
+         width = bitsFor(maxstep) ;
+         mode = MODE_DELTA ;
+         v[0] = 0 ;
+         for (int i=1; i<n; i++)
+            v[i] = col[i] - col[i-1] ;
+      } else {
+         for (int i=0; i<n; i++)
+            v[i] = col[i] - lo ;
+      }
+      unsigned char *h = buf + 4 + 12 * c ;
+      put32(h, lo) ;
+      put32(h+4, hi) ;
+      h[8] = width ;
+      h[9] = mode ;
+      h[10] = h[11] = 0 ;
+      bi->min[c] = lo ;
+      bi->max[c] = hi ;
+      len += packBits(v, n, width, buf + len) ;
+   }
+   put32(buf + BLOCKHEADERSZ - 4, len - BLOCKHEADERSZ) ;
+   if (fwrite(buf, 1, len, w->f) != (size_t)len)
+      return IO_ERROR ;
+   w->offset += len ;
+   w->nblocks++ ;
+   w->n = 0 ;
+   return 0 ;
+}
+int ccWriterAdd(struct ccWriter *w, const struct cubecoords *cc) {
+   w->col[0][w->n] = cc->epLex ;
+   w->col[1][w->n] = cc->eoMask ;
+   w->col[2][w->n] = cc->cpLex ;
+   w->col[3][w->n] = cc->coMask ;
+   if (++w->n == CC_BLOCK)
+      return flushBlock(w) ;
+   return 0 ;
+}
+/*
+ *   Write the last block, the end marker, and the index.
+ */
+int ccWriterClose(struct ccWriter *w) {
+   unsigned char e[INDEXENTRYSZ] ;
+   int err = flushBlock(w) ;
+   long long indexOffset = w->offset ;
+   put32(e, 0) ;
+   if (err == 0 && fwrite(e, 1, 4, w->f) != 4)
+      err = IO_ERROR ;
+   for (int b=0; err == 0 && b<w->nblocks; b++) {
+      put64(e, w->index[b].offset) ;
+      put32(e+8, w->index[b].count) ;
+      for (int c=0; c<CC_COLUMNS; c++) {
+         put32(e+12+8*c, w->index[b].min[c]) ;
+         put32(e+16+8*c, w->index[b].max[c]) ;
+      }
+      if (fwrite(e, 1, INDEXENTRYSZ, w->f) != INDEXENTRYSZ)
+         err = IO_ERROR ;
+   }
+   put64(e, indexOffset) ;
+   put32(e+8, w->nblocks) ;
+   memcpy(e+12, "CC3X", 4) ;
+   if (err == 0 && fwrite(e, 1, TRAILERSZ, w->f) != TRAILERSZ)
+      err = IO_ERROR ;
+   if (err == 0 && fflush(w->f) != 0)
+      err = IO_ERROR ;
+   free(w->index) ;
+   w->index = 0 ;
+   return err ;
+}
+int ccReaderOpen(struct ccReader *r, FILE *f) {
+   unsigned char h[HEADERSZ] ;
+   r->f = f ;
+   r->payload = 0 ;
+   r->payloadsz = 0 ;
+   r->done = 0 ;
+   r->index = 0 ;
+   r->nblocks = 0 ;
+   if (fread(h, 1, HEADERSZ, f) != HEADERSZ)
+      return IO_ERROR ;
+   if (memcmp(h, "CC3C", 4) != 0 || get32(h+4) != CC_VERSION ||
+       get32(h+8) != CC_BLOCK)
+      return BAD_CONTAINER ;
+   return 0 ;
+}
+/*
+ *   Read the next block into the columns, which must have room for
+ *   CC_BLOCK values.  Return the count, 0 at the end, or an error.
+ */
+int ccReadBlock(struct ccReader *r, int *epLex, int *eoMask, int *cpLex,
+                int *coMask) {
+   unsigned char h[BLOCKHEADERSZ] ;
+   int *cols[CC_COLUMNS] = { epLex, eoMask, cpLex, coMask } ;
+   if (r->done)
+      return 0 ;
+   if (fread(h, 1, 4, r->f) != 4)
+      return BAD_CONTAINER ;
+   int n = get32(h) ;
+   if (n == 0) {
+      r->done = 1 ;
+      return 0 ;
+   }
+   if (n < 0 || n > CC_BLOCK || fread(h+4, 1, BLOCKHEADERSZ-4, r->f) != BLOCKHEADERSZ-4)
+      return BAD_CONTAINER ;
+   int len = get32(h + BLOCKHEADERSZ - 4) ;
+   if (len < 0 || len > CC_COLUMNS * CC_BLOCK * 4)
+      return BAD_CONTAINER ;
+   if (len + 8 > r->payloadsz) {
+      unsigned char *t = realloc(r->payload, len + 8) ;
+      if (t == 0)
+         return OUT_OF_MEMORY ;
+      r->payload = t ;
+      r->payloadsz = len + 8 ;
+   }
+   if (fread(r->payload, 1, len, r->f) != (size_t)len)
+      return BAD_CONTAINER ;
+   memset(r->payload + len, 0, 8) ;
+   const unsigned char *p = r->payload ;
+   for (int c=0; c<CC_COLUMNS; c++) {
+      const unsigned char *ch = h + 4 + 12 * c ;
+      int lo = get32(ch), hi = get32(ch+4), width = ch[8], mode = ch[9] ;
+      int bytes = (int)(((long long)n * width + 7) >> 3) ;
+      if (lo < 0 || hi < lo || hi >= columnLimit[c] || width > 29 ||
+          mode > MODE_DELTA || p + bytes > r->payload + len)
+         return BAD_CONTAINER ;
+      if (unpackBits(p, n, width, mode, lo, hi, cols[c]))
+         return BAD_CONTAINER ;
+      p += bytes ;
+   }
+   return n ;
+}
+/*
+ *   Load the block index from the end of a seekable file.
+ */
+int ccReadIndex(struct ccReader *r) {
+   unsigned char e[INDEXENTRYSZ] ;
+   if (fseek(r->f, -TRAILERSZ, SEEK_END) != 0 ||
+       fread(e, 1, TRAILERSZ, r->f) != TRAILERSZ)
+      return IO_ERROR ;
+   long long filesz = ftell(r->f) ;
+   if (filesz < 0)
+      return IO_ERROR ;
+   if (memcmp(e+12, "CC3X", 4) != 0)
+      return BAD_CONTAINER ;
+   long long indexOffset = get64(e) ;
+   long long nblocks = get32(e+8) ;
+   // the index has to sit exactly between the blocks and the trailer
+   if (indexOffset < HEADERSZ ||
+       indexOffset + 4 + nblocks * INDEXENTRYSZ + TRAILERSZ != filesz ||
+       fseek(r->f, indexOffset + 4, SEEK_SET) != 0)
+      return BAD_CONTAINER ;
+   free(r->index) ;
+   r->nblocks = 0 ;
+   r->index = malloc((nblocks ? nblocks : 1) * sizeof(struct ccBlockInfo)) ;
+   if (r->index == 0)
+      return OUT_OF_MEMORY ;
+   for (int b=0; b<nblocks; b++) {
+      if (fread(e, 1, INDEXENTRYSZ, r->f) != INDEXENTRYSZ)
+         return BAD_CONTAINER ;
+      r->index[b].offset = get64(e) ;
+      r->index[b].count = get32(e+8) ;
+      long long prev = b ? r->index[b-1].offset : HEADERSZ - 1 ;
+      if (r->index[b].offset <= prev ||
+          r->index[b].offset + BLOCKHEADERSZ > indexOffset ||
+          r->index[b].count <= 0 || r->index[b].count > CC_BLOCK)
+         return BAD_CONTAINER ;
+      for (int c=0; c<CC_COLUMNS; c++) {
+         r->index[b].min[c] = get32(e+12+8*c) ;
+         r->index[b].max[c] = get32(e+16+8*c) ;
+         if (r->index[b].min[c] < 0 ||
+             r->index[b].max[c] < r->index[b].min[c] ||
+             r->index[b].max[c] >= columnLimit[c])
+            return BAD_CONTAINER ;
+      }
+   }
+   r->nblocks = nblocks ;
+   return 0 ;
+}
+/*
+ *   Read block number b; needs the index.
+ */
+int ccReadBlockAt(struct ccReader *r, int b, int *epLex, int *eoMask,
+                  int *cpLex, int *coMask) {
+   if (r->index == 0 || b < 0 || b >= r->nblocks)
+      return BAD_CONTAINER ;
+   if (fseek(r->f, r->index[b].offset, SEEK_SET) != 0)
+      return IO_ERROR ;
+   r->done = 0 ;
+   return ccReadBlock(r, epLex, eoMask, cpLex, coMask) ;
+}
+void ccReaderClose(struct ccReader *r) {
+   free(r->payload) ;
+   free(r->index) ;
+   r->payload = 0 ;
+   r->index = 0 ;
+}
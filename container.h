@@ -0,0 +1,47 @@
+/*
+ *   A compressed columnar container for large collections of states.
+ */
+#ifndef CONTAINER_H
+#include <stdio.h>
+#include "cubecoords.h"
+#define CC_BLOCK 4096          /* states per block */
+#define CC_COLUMNS 4           /* epLex, eoMask, cpLex, coMask */
+struct ccBlockInfo {
+   long long offset ;          /* file offset of the block header */
+   int count ;
+   int min[CC_COLUMNS] ;
+   int max[CC_COLUMNS] ;
+} ;
+struct ccWriter {
+   FILE *f ;
+   long long offset ;
+   int n ;
+   int col[CC_COLUMNS][CC_BLOCK] ;
+   struct ccBlockInfo *index ;
+   int nblocks ;
+   int maxblocks ;
+   unsigned char out[4 + 12 * CC_COLUMNS + 4 + CC_COLUMNS * CC_BLOCK * 4] ;
+} ;
+struct ccReader {
+   FILE *f ;
+   unsigned char *payload ;
+   int payloadsz ;
+   int done ;
+   struct ccBlockInfo *index ; /* only after ccReadIndex */
+   int nblocks ;
+} ;
+/*
+ *   Routines in container.c
+ */
+extern int ccWriterOpen(struct ccWriter *w, FILE *f) ;
+extern int ccWriterAdd(struct ccWriter *w, const struct cubecoords *cc) ;
+extern int ccWriterClose(struct ccWriter *w) ;
+extern int ccReaderOpen(struct ccReader *r, FILE *f) ;
+extern int ccReadBlock(struct ccReader *r, int *epLex, int *eoMask,
+                       int *cpLex, int *coMask) ;
+extern int ccReadIndex(struct ccReader *r) ;
+extern int ccReadBlockAt(struct ccReader *r, int block, int *epLex,
+                         int *eoMask, int *cpLex, int *coMask) ;
+extern void ccReaderClose(struct ccReader *r) ;
+#define CONTAINER_H
+#endif
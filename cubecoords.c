@@ -1,4 +1,9 @@
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "cubecoords.h"
+#include "index.h"
 #include "errors.h"
 unsigned char *tobytes11(const struct cubecoords *cc, unsigned char *p) {
    p[0] = cc->epLex >> 21 ;
@@ -38,3 +43,183 @@ int frombytes11(const unsigned char *p, struct cubecoords *cc) {
    cc->moMask = ((p[9] & 017) << 8) + p[10] ;
    return 0 ;
 }
+/*
+ *   Bulk forms of the above for whole arrays of records, unpacked to
+ *   and packed from one column per component.  Each record is read as
+ *   a big-endian 64-bit word (bytes 0..7) and a 32-bit word (bytes
+ *   7..10) so every field is one shift and mask.  Only the four
+ *   columns are kept; the puzzle and center orientation fields must
+ *   be the supported values and are written back as such.
+ */
+static unsigned long long load64be(const unsigned char *p) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   unsigned long long v ;
+   memcpy(&v, p, 8) ;
+   return __builtin_bswap64(v) ;
+#else
+   unsigned long long v = 0 ;
+   for (int i=0; i<8; i++)
+      v = (v << 8) + p[i] ;
+   return v ;
+#endif
+}
+static unsigned int load32be(const unsigned char *p) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   unsigned int v ;
+   memcpy(&v, p, 4) ;
+   return __builtin_bswap32(v) ;
+#else
+   return ((unsigned int)p[0] << 24) + (p[1] << 16) + (p[2] << 8) + p[3] ;
+#endif
+}
+static void store64be(unsigned char *p, unsigned long long v) {
+#if defined(__GNUC__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+   v = __builtin_bswap64(v) ;
+   memcpy(p, &v, 8) ;
+#else
+   for (int i=7; i>=0; i--, v >>= 8)
+      p[i] = v ;
+#endif
+}
+/*
+ *   Unpack n records.  Bit i&7 of errbits[i>>3] is set if record i
+ *   would fail frombytes11; the count of such records is returned.
+ *   The columns are filled in for bad records too.
+ */
+int frombytes11Bulk(const unsigned char *p, int n, int *epLex, int *eoMask,
+                    int *cpLex, int *coMask, unsigned char *errbits) {
+   memset(errbits, 0, (n + 7) >> 3) ;
+   for (int i=0; i<n; i++, p += 11) {
+      unsigned long long hi = load64be(p) ;
+      unsigned int lo = load32be(p+7) ;
+      epLex[i] = hi >> 35 ;
+      eoMask[i] = (hi >> 23) & 07777 ;
+      cpLex[i] = (hi >> 7) & 0177777 ;
+      coMask[i] = (lo >> 18) & 017777 ;
+      // poIdxU must be 7 and moSupport 0
+      errbits[i>>3] |= ((lo & 0x39000) != 0x38000) << (i & 7) ;
+   }
+   int i = 0 ;
+#ifdef __SSE2__
+   const __m128i epLim = _mm_set1_epi32(479001600-1) ;
+   const __m128i cpLim = _mm_set1_epi32(40320-1) ;
+   const __m128i coLim = _mm_set1_epi32(6561-1) ;
+   for (; i+8<=n; i+=8) {
+      int bad = 0 ;
+      for (int h=0; h<8; h+=4) {
+         __m128i b = _mm_or_si128(
+            _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(epLex+i+h)),
+                            epLim),
+            _mm_or_si128(
+            _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(cpLex+i+h)),
+                            cpLim),
+            _mm_cmpgt_epi32(_mm_loadu_si128((const __m128i *)(coMask+i+h)),
+                            coLim))) ;
+         bad |= _mm_movemask_ps(_mm_castsi128_ps(b)) << h ;
+      }
+      errbits[i>>3] |= bad ;
+   }
+#endif
+   for (; i<n; i++)
+      errbits[i>>3] |= (epLex[i] >= 479001600 || cpLex[i] >= 40320 ||
+                        coMask[i] >= 6561) << (i & 7) ;
+   int bad = 0 ;
+   for (int j=0; j<(n+7)>>3; j++)
+      for (int b=errbits[j]; b; b &= b-1)
+         bad++ ;
+   return bad ;
+}
+/*
+ *   Pack n records from the columns.
+ */
+void tobytes11Bulk(const int *epLex, const int *eoMask, const int *cpLex,
+                   const int *coMask, int n, unsigned char *p) {
+   for (int i=0; i<n; i++, p += 11) {
+      store64be(p, ((unsigned long long)epLex[i] << 35) +
+                   ((unsigned long long)eoMask[i] << 23) +
+                   ((unsigned long long)cpLex[i] << 7) + (coMask[i] >> 6)) ;
+      p[8] = (coMask[i] << 2) + 3 ;   // poIdxU is 7
+      p[9] = 0x80 ;
+      p[10] = 0 ;
+   }
+}
+/*
+ *   Make sure every edge and corner cubie is present exactly once.
+ *   This is the check encodePerm makes, without computing the rank.
+ */
+int checkCubies(const struct cubies *cu) {
+   int seen = 0 ;
+   for (int i=0; i<12; i++)
+      seen |= 1 << (cu->e[i] >> 1) ;
+   if (seen != 07777)
+      return MISSING_EDGE_CUBIE ;
+   seen = 0 ;
+   for (int i=0; i<8; i++)
+      seen |= 1 << (cu->c[i] >> 2) ;
+   if (seen != 0377)
+      return MISSING_CORNER_CUBIE ;
+   return 0 ;
+}
+/*
+ *   Rank the cubies into the components.
+ */
+int cubiesToComponents(const struct cubies *cu, struct cubecoords *cc) {
+   unsigned char perm[12] ;
+   int edgeo = 0 ;
+   int cornero = 0 ;
+   for (int i=0; i<12; i++) {
+      perm[i] = cu->e[i] >> 1 ;
+      edgeo = 2 * edgeo + (cu->e[i] & 1) ;
+   }
+   int edgeperm = encodePerm(perm, 12) ;
+   if (edgeperm < 0)
+      return MISSING_EDGE_CUBIE ;
+   for (int i=0; i<8; i++) {
+      perm[i] = cu->c[i] >> 2 ;
+      cornero = 3 * cornero + (cu->c[i] & 3) ;
+   }
+   int cornerperm = encodePerm(perm, 8) ;
+   if (cornerperm < 0)
+      return MISSING_CORNER_CUBIE ;
+   cc->cpLex = cornerperm ;
+   cc->coMask = cornero ;
+   cc->poIdxU = 7 ;
+   cc->epLex = edgeperm ;
+   cc->poIdxL = 0 ;
+   cc->moSupport = 0 ;
+   cc->eoMask = edgeo ;
+   cc->moMask = 0 ;
+   return 0 ;
+}
+/*
+ *   Unrank the components into cubies.  This is the only place the
+ *   output conversions unrank, so do it once and reuse the cubies
+ *   for every output format.
+ */
+int componentsToCubies(const struct cubecoords *cc, struct cubies *cu) {
+   unsigned char perm[12] ;
+   int eo = cc->eoMask ;
+   decodePerm(cc->epLex, perm, 12) ;
+   for (int i=0; i<12; i++)
+      cu->e[i] = 2*perm[i]+(1&(eo>>(11-i))) ;
+   decodePerm(cc->cpLex, perm, 8) ;
+   int co = cc->coMask ;
+#ifdef NO_HARDWARE_DIVIDE
+   // base-3 digits from the top by subtraction; no divide needed
+   static const short pow3[] = { 2187, 729, 243, 81, 27, 9, 3, 1 } ;
+   for (int i=0; i<8; i++) {
+      int d = 0 ;
+      while (co >= pow3[i]) {
+         co -= pow3[i] ;
+         d++ ;
+      }
+      cu->c[i] = 4*perm[i]+d ;
+   }
+#else
+   for (int i=7; i>=0; i--) {
+      cu->c[i] = 4*perm[i]+(co%3) ;
+      co /= 3 ;
+   }
+#endif
+   return 0 ;
+}
@@ -12,10 +12,29 @@ struct cubecoords {
    int moSupport ;/* center orientation support; 0..1 */
    int moMask ;   /* center orientation; 0..4095 */
 } ;
+/*
+ *   The same state as cubies by position, in the Reid order.  Each
+ *   edge is its cubie index * 2 + orientation, and each corner is its
+ *   cubie index * 4 + orientation.  This is the common midpoint of all
+ *   the external formats; getting here needs no ranking or unranking.
+ */
+struct cubies {
+   unsigned char e[12] ;
+   unsigned char c[8] ;
+} ;
 /*
  *   Routines in cubecoords.c
  */
 extern unsigned char *tobytes11(const struct cubecoords *cc, unsigned char *p) ;
 extern int frombytes11(const unsigned char *p, struct cubecoords *cc) ;
+extern int frombytes11Bulk(const unsigned char *p, int n, int *epLex,
+                       int *eoMask, int *cpLex, int *coMask,
+                       unsigned char *errbits) ;
+extern void tobytes11Bulk(const int *epLex, const int *eoMask,
+                          const int *cpLex, const int *coMask, int n,
+                          unsigned char *p) ;
+extern int checkCubies(const struct cubies *cu) ;
+extern int cubiesToComponents(const struct cubies *cu, struct cubecoords *cc) ;
+extern int componentsToCubies(const struct cubecoords *cc, struct cubies *cu) ;
 #define CUBECOORDS_H
 #endif
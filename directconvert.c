@@ -0,0 +1,93 @@
+/**
+ *   Convert directly between the sticker, heykube, and Reid formats.
+ *
+ *   Each format already knows the cubie in every position, so we
+ *   meet in the middle at struct cubies and never rank or unrank
+ *   the permutations.  The only check the ranking would have added
+ *   is that every cubie is present, and checkCubies does that.
+ */
+#include "cubecoords.h"
+#include "stickerstobin.h"
+#include "heykubetobin.h"
+#include "reidtobin.h"
+#include "directconvert.h"
+int stickersToHeykube(const unsigned char *stickers,
+                      unsigned char *kubeperm) {
+   struct cubies cu ;
+   int err = stickersToCubies(stickers, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToHeykube(&cu, kubeperm) ;
+   return err ;
+}
+int heykubeToStickers(const unsigned char *kubeperm,
+                      unsigned char *stickers) {
+   struct cubies cu ;
+   int err = heykubeToCubies(kubeperm, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToStickers(&cu, stickers) ;
+   return err ;
+}
+int stickersToReid(const unsigned char *stickers, char *Reid) {
+   struct cubies cu ;
+   int err = stickersToCubies(stickers, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToReid(&cu, Reid) ;
+   return err ;
+}
+int ReidToStickers(const char *Reid, unsigned char *stickers) {
+   struct cubies cu ;
+   int err = ReidToCubies(Reid, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToStickers(&cu, stickers) ;
+   return err ;
+}
+int heykubeToReid(const unsigned char *kubeperm, char *Reid) {
+   struct cubies cu ;
+   int err = heykubeToCubies(kubeperm, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToReid(&cu, Reid) ;
+   return err ;
+}
+int ReidToHeykube(const char *Reid, unsigned char *kubeperm) {
+   struct cubies cu ;
+   int err = ReidToCubies(Reid, &cu) ;
+   if (err == 0)
+      err = checkCubies(&cu) ;
+   if (err == 0)
+      err = cubiesToHeykube(&cu, kubeperm) ;
+   return err ;
+}
+/*
+ *   Render several formats from one state; pass a null pointer for
+ *   any format that is not wanted.  The components are unranked only
+ *   once, however many formats are asked for.
+ */
+int cubiesToFormats(const struct cubies *cu, char *Reid,
+                    unsigned char *stickers, unsigned char *kubeperm) {
+   int err = 0 ;
+   if (Reid)
+      err = cubiesToReid(cu, Reid) ;
+   if (err == 0 && stickers)
+      err = cubiesToStickers(cu, stickers) ;
+   if (err == 0 && kubeperm)
+      err = cubiesToHeykube(cu, kubeperm) ;
+   return err ;
+}
+int componentsToFormats(const struct cubecoords *cc, char *Reid,
+                        unsigned char *stickers, unsigned char *kubeperm) {
+   struct cubies cu ;
+   int err = componentsToCubies(cc, &cu) ;
+   if (err == 0)
+      err = cubiesToFormats(&cu, Reid, stickers, kubeperm) ;
+   return err ;
+}
@@ -0,0 +1,19 @@
+/*
+ *   Routines exported.
+ */
+#ifndef DIRECTCONVERT_H
+#include "cubecoords.h"
+extern int stickersToHeykube(const unsigned char *stickers,
+                             unsigned char *heykubePerm) ;
+extern int heykubeToStickers(const unsigned char *heykubePerm,
+                             unsigned char *stickers) ;
+extern int stickersToReid(const unsigned char *stickers, char *Reid) ;
+extern int ReidToStickers(const char *Reid, unsigned char *stickers) ;
+extern int heykubeToReid(const unsigned char *heykubePerm, char *Reid) ;
+extern int ReidToHeykube(const char *Reid, unsigned char *heykubePerm) ;
+extern int cubiesToFormats(const struct cubies *cu, char *Reid,
+                       unsigned char *stickers, unsigned char *heykubePerm) ;
+extern int componentsToFormats(const struct cubecoords *cc, char *Reid,
+                       unsigned char *stickers, unsigned char *heykubePerm) ;
+#define DIRECTCONVERT_H
+#endif
@@ -14,5 +14,20 @@
 #define REID_ELEMENT_OUT_OF_RANGE (-1013)
 #define WRONG_REID_LENGTH (-1014)
 #define BAD_MOVE_FORMAT (-1015)
+#define IO_ERROR (-1016)
+#define OUT_OF_MEMORY (-1017)
+#define PARTIAL_RECORD (-1018)
+#define MOVES_NOT_FOUND (-1019)
+#define BAD_INTEGER (-1020)
+#define INTEGER_OUT_OF_RANGE (-1021)
+#define TOO_MANY_TOKENS (-1022)
+#define BAD_TOKEN_COUNT (-1023)
+#define BAD_STICKER_VALUES (-1024)
+#define MISSING_SOLUTION (-1025)
+#define LINE_TOO_LONG (-1026)
+#define BAD_CONTAINER (-1027)
+#define BAD_FEATURE_NAME (-1028)
+#define UNSOLVABLE_ORIENTATION (-1029)
+#define MOVES_TOO_LONG (-1030)
 #define ERRORS_H
 #endif
@@ -0,0 +1,109 @@
+/*
+ *   Footprint harness for the embedded build.  Run with
+ *
+ *   ./footprint <conversion> <count>
+ *
+ *   to do one conversion count times over a fixed set of states.
+ *   All setup happens whatever the count, so the difference in
+ *   instructions retired between a run with count N and one with
+ *   count 0, divided by N times NSTATES, is the cost of a single
+ *   conversion; make footprint-insns does this under an instruction
+ *   counter such as the qemu-user insn plugin.  With no arguments it
+ *   lists the conversions.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "cubecoords.h"
+#include "stickerstobin.h"
+#include "heykubetobin.h"
+#include "reidtobin.h"
+#include "directconvert.h"
+#define NSTATES 16
+static struct cubecoords cc[NSTATES] ;
+static unsigned char bytes[NSTATES][11] ;
+static unsigned char stickers[NSTATES][54] ;
+static unsigned char kubeperm[NSTATES][54] ;
+static char Reid[NSTATES][68] ;
+volatile int sink ;
+static const char *conversions[] = {
+   "tobytes11", "frombytes11", "tostickers", "fromstickers", "toheykube",
+   "fromheykube", "toreid", "fromreid", "stickerstoheykube",
+   "heykubetostickers", "stickerstoreid", "reidtostickers", 0 } ;
+/*
+ *   Deterministic states; no library random number generator so the
+ *   setup costs the same everywhere.  Each value is masked to the
+ *   next power of two and brought into range with one subtraction,
+ *   so nothing here links in a software divide.
+ */
+static void makestates() {
+   unsigned int seed = 12345 ;
+   for (int i=0; i<NSTATES; i++) {
+      seed = seed * 1103515245 + 12345 ;
+      cc[i].epLex = (seed >> 3) & 0x1fffffff ;
+      if (cc[i].epLex >= 479001600)
+         cc[i].epLex -= 479001600 ;
+      seed = seed * 1103515245 + 12345 ;
+      cc[i].eoMask = (seed >> 8) & 07776 ;
+      seed = seed * 1103515245 + 12345 ;
+      cc[i].cpLex = (seed >> 8) & 0xffff ;
+      if (cc[i].cpLex >= 40320)
+         cc[i].cpLex -= 40320 ;
+      seed = seed * 1103515245 + 12345 ;
+      cc[i].coMask = (seed >> 8) & 0x1fff ;
+      if (cc[i].coMask >= 6561)
+         cc[i].coMask -= 6561 ;
+      cc[i].poIdxU = 7 ;
+      cc[i].poIdxL = cc[i].moSupport = cc[i].moMask = 0 ;
+      tobytes11(&cc[i], bytes[i]) ;
+      componentsToFormats(&cc[i], Reid[i], stickers[i], kubeperm[i]) ;
+   }
+}
+static int convert(int which, int i) {
+   struct cubecoords t ;
+   unsigned char out[68] ;
+   switch (which) {
+case 0:  return tobytes11(&cc[i], out)[0] ;
+case 1:  return frombytes11(bytes[i], &t) ;
+case 2:  return componentsToStickers(&cc[i], out) ;
+case 3:  return stickersToComponents(stickers[i], &t) ;
+case 4:  return componentsToHeykube(&cc[i], out) ;
+case 5:  return heykubeToComponents(kubeperm[i], &t) ;
+case 6:  return componentsToReid(&cc[i], (char *)out) ;
+case 7:  return ReidToComponents(Reid[i], &t) ;
+case 8:  return stickersToHeykube(stickers[i], out) ;
+case 9:  return heykubeToStickers(kubeperm[i], out) ;
+case 10: return stickersToReid(stickers[i], (char *)out) ;
+case 11: return ReidToStickers(Reid[i], out) ;
+default: return 0 ;
+   }
+}
+/*
+ *   Decimal count; strtol and printf would bring in division.
+ */
+static int parsecount(const char *s) {
+   int n = 0 ;
+   while (*s >= '0' && *s <= '9')
+      n = 10 * n + *s++ - '0' ;
+   return n ;
+}
+int main(int argc, char *argv[]) {
+   if (argc < 3) {
+      for (int i=0; conversions[i]; i++)
+         puts(conversions[i]) ;
+      return 0 ;
+   }
+   int which = -1 ;
+   for (int i=0; conversions[i]; i++)
+      if (strcmp(argv[1], conversions[i]) == 0)
+         which = i ;
+   if (which < 0) {
+      fputs("footprint: unknown conversion\n", stderr) ;
+      return 10 ;
+   }
+   int count = parsecount(argv[2]) ;
+   makestates() ;
+   for (int n=0; n<count; n++)
+      for (int i=0; i<NSTATES; i++)
+         sink += convert(which, i) ;
+   return 0 ;
+}
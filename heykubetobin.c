@@ -30,7 +30,6 @@ UF UR UB UL DF DR DB DL FR FL BR BL UFR URB UBL ULF DRF DFL DLB DBR U L F R B D
  0  1  2  3  4  5  6  7  8  9 10 11  12  13  14  15  16  17  18  19 20  .... 25
  */
 #include "cubecoords.h"
-#include "index.h"
 #include "heykubetobin.h"
 #include "errors.h"
 static const unsigned char ReidOrder[] = {
@@ -110,76 +109,80 @@ static const int cornerExpand[] = { 181202, 62636, 76559, 0, 173595,
    0, 218970, 120501, 109917, 0 } ;
 #endif
 /*
- *   From an array of cubie values, calculate the relevant
- *   permutations and orientations.  Ensure all needed cubies are seen.
+ *   The face (color) of a sticker.  Without a hardware divide even a
+ *   division by a constant can turn into a library call, so use a
+ *   table instead.
  */
-int heykubeToComponents(const unsigned char *kubeperm, struct cubecoords *cc) {
+#ifdef NO_HARDWARE_DIVIDE
+static const unsigned char faceOf[] = {
+   0, 0, 0, 0, 0, 0, 0, 0, 0,  1, 1, 1, 1, 1, 1, 1, 1, 1,
+   2, 2, 2, 2, 2, 2, 2, 2, 2,  3, 3, 3, 3, 3, 3, 3, 3, 3,
+   4, 4, 4, 4, 4, 4, 4, 4, 4,  5, 5, 5, 5, 5, 5, 5, 5, 5 } ;
+#define FACE(s) faceOf[s]
+#else
+#define FACE(s) ((s)/9)
+#endif
+/*
+ *   From a permutation, find the cubie in each position.  Ensure
+ *   every cubie is legal and the centers are in place.
+ */
+int heykubeToCubies(const unsigned char *kubeperm, struct cubies *cu) {
    initializeHeyKubeTable() ;
-   unsigned char perm[12] ;
-   int edgeo = 0 ;
-   int cornero = 0 ;
    for (int i=0; i<54; i++)
       if (kubeperm[i] > 53)
          return PERM_ELEMENT_OUT_OF_RANGE ;
    for (int i=0; i<12; i++) {
-      int cubie = edgeLookup[6*(kubeperm[ReidOrder[2*i]]/9)+
-                                kubeperm[ReidOrder[2*i+1]]/9] ;
+      int cubie = edgeLookup[6*FACE(kubeperm[ReidOrder[2*i]])+
+                                FACE(kubeperm[ReidOrder[2*i+1]])] ;
       if (cubie == 255 || edgeExpand[cubie] !=
                     (kubeperm[ReidOrder[2*i]]<<6)+kubeperm[ReidOrder[2*i+1]])
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = cubie >> 1 ;
-      edgeo = 2 * edgeo + (cubie & 1) ;
+      cu->e[i] = cubie ;
    }
-   int edgeperm = encodePerm(perm, 12) ;
-   if (edgeperm < 0)
-      return MISSING_EDGE_CUBIE ;
    for (int i=0; i<8; i++) {
-      int cubie = cornerLookup[6*(kubeperm[ReidOrder[3*i+24]]/9)+
-                                  kubeperm[ReidOrder[3*i+25]]/9] ;
+      int cubie = cornerLookup[6*FACE(kubeperm[ReidOrder[3*i+24]])+
+                                  FACE(kubeperm[ReidOrder[3*i+25]])] ;
       if (cubie == 255 || cornerExpand[cubie] !=
           (kubeperm[ReidOrder[3*i+24]]<<12)+(kubeperm[ReidOrder[3*i+25]]<<6)+
            kubeperm[ReidOrder[3*i+26]])
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = (cubie >> 2) ;
-      cornero = 3 * cornero + (cubie & 3) ;
+      cu->c[i] = cubie ;
    }
-   int cornerperm = encodePerm(perm, 8) ;
-   if (cornerperm < 0)
-      return MISSING_CORNER_CUBIE ;
    for (int i=0; i<6; i++)
-      perm[i] = kubeperm[ReidOrder[i+48]]/9 ;
-   if (encodePerm(perm, 6) != 0)
-      return PUZZLE_ORIENTATION_NOT_SUPPORTED ;
-   cc->cpLex = cornerperm ;
-   cc->coMask = cornero ;
-   cc->poIdxU = 7 ;
-   cc->epLex = edgeperm ;
-   cc->poIdxL = 0 ;
-   cc->moSupport = 0 ;
-   cc->eoMask = edgeo ;
-   cc->moMask = 0 ;
+      if (FACE(kubeperm[ReidOrder[i+48]]) != i)
+         return PUZZLE_ORIENTATION_NOT_SUPPORTED ;
    return 0 ;
 }
-int componentsToHeykube(const struct cubecoords *cc, unsigned char *kubeperm) {
+int cubiesToHeykube(const struct cubies *cu, unsigned char *kubeperm) {
    initializeHeyKubeTable() ;
-   unsigned char perm[12] ;
-   int eo = cc->eoMask ;
-   decodePerm(cc->epLex, perm, 12) ;
    for (int i=0; i<12; i++) {
-      int colors = edgeExpand[2*perm[i]+(1&(eo>>(11-i)))] ;
+      int colors = edgeExpand[cu->e[i]] ;
       kubeperm[ReidOrder[2*i]] = colors >> 6 ;
       kubeperm[ReidOrder[2*i+1]] = colors & 63 ;
    }
-   decodePerm(cc->cpLex, perm, 8) ;
-   int co = cc->coMask ;
-   for (int i=7; i>=0; i--) {
-      int colors = cornerExpand[4*perm[i]+(co%3)] ;
+   for (int i=0; i<8; i++) {
+      int colors = cornerExpand[cu->c[i]] ;
       kubeperm[ReidOrder[3*i+24]] = colors >> 12 ;
       kubeperm[ReidOrder[3*i+25]] = (colors >> 6) & 63 ;
       kubeperm[ReidOrder[3*i+26]] = colors & 63 ;
-      co /= 3 ;
    }
    for (int i=0; i<6; i++)
       kubeperm[ReidOrder[i+48]] = ReidOrder[i+48] ;
    return 0 ;
 }
+/*
+ *   From an array of cubie values, calculate the relevant
+ *   permutations and orientations.  Ensure all needed cubies are seen.
+ */
+int heykubeToComponents(const unsigned char *kubeperm, struct cubecoords *cc) {
+   struct cubies cu ;
+   int err = heykubeToCubies(kubeperm, &cu) ;
+   if (err == 0)
+      err = cubiesToComponents(&cu, cc) ;
+   return err ;
+}
+int componentsToHeykube(const struct cubecoords *cc, unsigned char *kubeperm) {
+   struct cubies cu ;
+   componentsToCubies(cc, &cu) ;
+   return cubiesToHeykube(&cu, kubeperm) ;
+}
@@ -7,5 +7,9 @@ extern int heykubeToComponents(const unsigned char *heykubePerm,
                                struct cubecoords *cc) ;
 extern int componentsToHeykube(const struct cubecoords *cc,
                                unsigned char *heykubePerm) ;
+extern int heykubeToCubies(const unsigned char *heykubePerm,
+                           struct cubies *cu) ;
+extern int cubiesToHeykube(const struct cubies *cu,
+                           unsigned char *heykubePerm) ;
 #define HEYKUBETOBIN_H
 #endif
@@ -25,6 +25,31 @@ int encodePerm(const unsigned char *a, int n) {
  *   Unindex a perm.  This can be made faster if the CPU has
  *   64-bit ints but microcontrollers might not have such.
  */
+#ifdef NO_HARDWARE_DIVIDE
+/*
+ *   Microcontrollers may not have a divide instruction either, so
+ *   peel the digits off the top by subtracting factorials instead;
+ *   at most n-1-i subtractions for digit i.
+ */
+static const int factorial[] = { 1, 1, 2, 6, 24, 120, 720, 5040, 40320,
+   362880, 3628800, 39916800 } ;
+void decodePerm(int lex, unsigned char *a, int n) {
+   a[n-1] = 0 ;
+   for (int i=0; i<n-1; i++) {
+      int f = factorial[n-1-i] ;
+      int d = 0 ;
+      while (lex >= f) {
+         lex -= f ;
+         d++ ;
+      }
+      a[i] = d ;
+   }
+   for (int i=n-2; i>=0; i--)
+      for (int j=i+1; j<n; j++)
+         if (a[j] >= a[i])
+            a[j]++ ;
+}
+#else
 void decodePerm(int lex, unsigned char *a, int n) {
    a[n-1] = 0 ;
    for (int i=n-2; i>=0; i--) {
@@ -35,3 +60,4 @@ void decodePerm(int lex, unsigned char *a, int n) {
             a[j]++ ;
    }
 }
+#endif
@@ -21,8 +21,59 @@ void iota(perm a) {
       a[i] = i ;
 }
 static perm allmoves[18] ;
+static struct cubies cubiemoves[18] ;   // the same moves on cubies
+/*
+ *   To recognize moves from pairs of states, we hash the permutation
+ *   that takes one state to the other.  The table holds every
+ *   sequence of up to two moves on different faces; sequences of
+ *   two commuting moves are only stored in one order.
+ */
+#define DIFFHASHSZ 1024
+struct movediff {
+   perm p ;
+   unsigned char nmoves ;
+   unsigned char mv[2] ;
+} ;
+static struct movediff diffs[1+18+18*15] ;
+static short diffhash[DIFFHASHSZ] ;     // index into diffs + 1; 0 is empty
+static int ndiffs ;
+static int hashperm(const perm a) {
+   unsigned int h = 0 ;
+   for (int i=0; i<PERM_N; i++)
+      h = 31 * h + a[i] ;
+   return (h ^ (h >> 10)) & (DIFFHASHSZ - 1) ;
+}
+static int finddiff(const perm a) {
+   for (int h=hashperm(a); diffhash[h]; h = (h + 1) & (DIFFHASHSZ - 1)) {
+      struct movediff *d = &diffs[diffhash[h]-1] ;
+      int i = 0 ;
+      while (i < PERM_N && d->p[i] == a[i])
+         i++ ;
+      if (i == PERM_N)
+         return diffhash[h] - 1 ;
+   }
+   return -1 ;
+}
+static void adddiff(const perm a, int nmoves, int mv0, int mv1) {
+   if (finddiff(a) >= 0)
+      return ;
+   struct movediff *d = &diffs[ndiffs] ;
+   for (int i=0; i<PERM_N; i++)
+      d->p[i] = a[i] ;
+   d->nmoves = nmoves ;
+   d->mv[0] = mv0 ;
+   d->mv[1] = mv1 ;
+   int h = hashperm(a) ;
+   while (diffhash[h])
+      h = (h + 1) & (DIFFHASHSZ - 1) ;
+   diffhash[h] = ++ndiffs ;
+}
 static int inited = 0 ;
-static void initmoves() {
+/*
+ *   Build the move tables.  This happens on first use, but callers
+ *   using the moves from several threads should call it up front.
+ */
+void initmoves() {
    if (inited)
       return ;
    for (int i=0; i<6; i++) {
@@ -30,6 +81,19 @@ static void initmoves() {
       for (int m=1; m<3; m++)
          permmul(allmoves[3*i+m-1], allmoves[3*i], allmoves[3*i+m]) ;
    }
+   for (int mv=0; mv<18; mv++)
+      heykubeToCubies(allmoves[mv], &cubiemoves[mv]) ;
+   perm t ;
+   iota(t) ;
+   adddiff(t, 0, 0, 0) ;
+   for (int m0=0; m0<18; m0++)
+      adddiff(allmoves[m0], 1, m0, 0) ;
+   for (int m0=0; m0<18; m0++)
+      for (int m1=0; m1<18; m1++)
+         if (m0 / 3 != m1 / 3) {
+            permmul(allmoves[m0], allmoves[m1], t) ;
+            adddiff(t, 2, m0, m1) ;
+         }
    inited = 1 ;
 }
 void domove(perm a, int mv) {
@@ -39,27 +103,167 @@ void domove(perm a, int mv) {
    for (int i=0; i<PERM_N; i++)
       a[i] = t[i] ;
 }
+/*
+ *   Parse the next move, advancing the string past it.  Returns the
+ *   move, END_OF_MOVES, or BAD_MOVE_FORMAT.
+ */
+#define END_OF_MOVES (-1)
+static int nextmove(const char **sp) {
+   const char *s = *sp ;
+   while (*s && *s <= ' ')
+      s++ ;
+   if (!*s)
+      return END_OF_MOVES ;
+   int mv = -1 ;
+   for (int i=0; i<6; i++)
+      if (*s == basemoves[i].movename)
+         mv = 3*i ;
+   if (mv < 0)
+      return BAD_MOVE_FORMAT ;
+   s++ ;
+   if (*s == '2') {
+      mv++ ;
+      s++ ;
+   } else if (*s == '\'') {
+      mv += 2 ;
+      s++ ;
+   }
+   *sp = s ;
+   return mv ;
+}
 int domoves(perm a, const char *s) {
    for (;;) {
-      while (*s && *s <= ' ')
-         s++ ;
-      if (!*s)
-         return 0 ;
-      int mv = -1 ;
-      for (int i=0; i<6; i++)
-         if (*s == basemoves[i].movename)
-            mv = 3*i ;
+      int mv = nextmove(&s) ;
       if (mv < 0)
-         return BAD_MOVE_FORMAT ;
-      s++ ;
-      if (*s == '2') {
-         mv++ ;
-         s++ ;
-      } else if (*s == '\'') {
-         mv += 2 ;
-         s++ ;
-      }
+         return mv == END_OF_MOVES ? 0 : mv ;
       domove(a, mv) ;
    }
-   return 0 ;
+}
+/*
+ *   Moves on the cubie form.  The cubie that lands in each position
+ *   comes from the position the move table names, with the move's
+ *   flip or twist added to its orientation.
+ */
+void domoveCubies(struct cubies *cu, int mv) {
+   static const unsigned char mod3[] = { 0, 1, 2, 0, 1 } ;
+   initmoves() ;
+   const struct cubies *m = &cubiemoves[mv] ;
+   struct cubies t ;
+   for (int i=0; i<12; i++)
+      t.e[i] = cu->e[m->e[i]>>1] ^ (m->e[i] & 1) ;
+   for (int i=0; i<8; i++) {
+      int c = cu->c[m->c[i]>>2] ;
+      t.c[i] = (c & ~3) + mod3[(c & 3) + (m->c[i] & 3)] ;
+   }
+   *cu = t ;
+}
+/*
+ *   Apply a move sequence to cubies; return the number of moves.
+ */
+int domovesCubies(struct cubies *cu, const char *s) {
+   int n = 0 ;
+   for (;; n++) {
+      int mv = nextmove(&s) ;
+      if (mv < 0)
+         return mv == END_OF_MOVES ? n : mv ;
+      domoveCubies(cu, mv) ;
+   }
+}
+static char *movename(int mv, char *s) {
+   *s++ = basemoves[mv/3].movename ;
+   if (mv % 3 == 1)
+      *s++ = '2' ;
+   else if (mv % 3 == 2)
+      *s++ = '\'' ;
+   *s = 0 ;
+   return s ;
+}
+/*
+ *   Simplify a move sequence:  merge moves of the same face, let
+ *   moves of opposite faces commute so they merge or cancel across
+ *   each other (U D U' is D), and write each commuting pair in a
+ *   fixed order (U before D, F before B, R before L).  The result is
+ *   a canonical form, so equivalent sequences under these rules give
+ *   the same string.  The moves are kept as a stack at the front of
+ *   out, one byte each, and then spelled out in place from the end.
+ *   Return the number of moves, BAD_MOVE_FORMAT, or MOVES_TOO_LONG
+ *   if out (outsz bytes) is too small.
+ */
+int simplifyMoves(const char *s, char *out, int outsz) {
+   unsigned char *st = (unsigned char *)out ;
+   int n = 0 ;
+   for (;;) {
+      int mv = nextmove(&s) ;
+      if (mv < 0) {
+         if (mv != END_OF_MOVES)
+            return mv ;
+         break ;
+      }
+      int f = mv / 3 ;
+      int q = mv % 3 + 1 ; // quarter turns
+      int k = -1 ; // the stack entry this move merges with
+      if (n > 0 && st[n-1] / 3 == f)
+         k = n - 1 ;
+      else if (n > 1 && st[n-1] / 3 == (f ^ 1) && st[n-2] / 3 == f)
+         k = n - 2 ;
+      if (k >= 0) {
+         q = (q + st[k] % 3 + 1) & 3 ;
+         if (q) {
+            st[k] = 3 * f + q - 1 ;
+         } else {
+            n-- ;
+            if (k != n)
+               st[k] = st[n] ;
+         }
+      } else {
+         if (n + 1 > outsz)
+            return MOVES_TOO_LONG ;
+         if (n > 0 && st[n-1] / 3 == (f ^ 1) && f < st[n-1] / 3) {
+            st[n] = st[n-1] ;
+            st[n-1] = mv ;
+         } else {
+            st[n] = mv ;
+         }
+         n++ ;
+      }
+   }
+   int len = 0 ;
+   for (int i=0; i<n; i++)
+      len += (i > 0) + 1 + (st[i] % 3 != 0) ;
+   if (len + 1 > outsz)
+      return MOVES_TOO_LONG ;
+   out[len] = 0 ;
+   for (int i=n-1; i>=0; i--) { // never overwrites an unread entry
+      int mv = st[i] ;
+      if (mv % 3 != 0)
+         out[--len] = mv % 3 == 1 ? '2' : '\'' ;
+      out[--len] = basemoves[mv/3].movename ;
+      if (i > 0)
+         out[--len] = ' ' ;
+   }
+   return n ;
+}
+/*
+ *   Given two consecutive states, find the moves that take the first
+ *   to the second.  The moves are written to movestr (at least 8
+ *   characters) and the count returned.  If no sequence of up to two
+ *   moves does it, return MOVES_NOT_FOUND; the gap needs a search.
+ */
+int inferMoves(const perm from, const perm to, char *movestr) {
+   initmoves() ;
+   perm inv, d ;
+   for (int i=0; i<PERM_N; i++)
+      inv[from[i]] = i ;
+   for (int i=0; i<PERM_N; i++)
+      d[i] = inv[to[i]] ;
+   int k = finddiff(d) ;
+   if (k < 0)
+      return MOVES_NOT_FOUND ;
+   *movestr = 0 ;
+   for (int i=0; i<diffs[k].nmoves; i++) {
+      if (i)
+         *movestr++ = ' ' ;
+      movestr = movename(diffs[k].mv[i], movestr) ;
+   }
+   return diffs[k].nmoves ;
 }
@@ -1,8 +1,14 @@
 #ifndef MOVES_H
+#include "cubecoords.h"
 #define PERM_N 54
 typedef unsigned char perm[PERM_N] ;
 extern void iota(perm a) ;
+extern void initmoves() ;
 extern void domove(perm a, int mv) ;
 extern int domoves(perm a, const char *s) ;
+extern void domoveCubies(struct cubies *cu, int mv) ;
+extern int domovesCubies(struct cubies *cu, const char *s) ;
+extern int simplifyMoves(const char *s, char *out, int outsz) ;
+extern int inferMoves(const perm from, const perm to, char *movestr) ;
 #define MOVES_H
 #endif
@@ -0,0 +1,140 @@
+/**
+ *   Recognize a cube state written as text in any of the input
+ *   formats, and convert it.
+ *
+ *   Binary component:  11 hex values
+ *   Decimal component:  4 decimal values
+ *   Kociemba phase coordinates:  6 decimal values
+ *   Reid:  20 cubies, starting with one of UFRDBL
+ *   Stickers:  54 values, max is 5
+ *   Heykube:  54 values, max is 53
+ *   Moves:  a move sequence applied to the solved cube
+ *
+ *   This does not modify the line and keeps no state, so it can be
+ *   used from several threads once initmoves has been called.
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "cubecoords.h"
+#include "stickerstobin.h"
+#include "heykubetobin.h"
+#include "reidtobin.h"
+#include "moves.h"
+#include "phasecoords.h"
+#include "parsestate.h"
+#include "errors.h"
+#define MAXTOKS 54
+static int iswhite(int c) {
+   return c <= ' ' ;
+}
+static int ismovestring(const char *a) {
+   return ((*a == 'U' || *a == 'F' || *a == 'R' ||
+            *a == 'D' || *a == 'B' || *a == 'L') &&
+           (iswhite(a[1]) || (iswhite(a[2]) &&
+                              (a[1] == '2' || a[1] == '\'')))) ;
+}
+static int toints(const char **toks, int n, int lo, int hi, int base,
+                  int *itoks) {
+   for (int i=0; i<n; i++) {
+      char *end ;
+      long v = strtol(toks[i], &end, base) ;
+      if (!iswhite(*end) || end == toks[i])
+         return BAD_INTEGER ;
+      if (v < lo || v >= hi)
+         return INTEGER_OUT_OF_RANGE ;
+      itoks[i] = v ;
+   }
+   return 0 ;
+}
+/*
+ *   Parse one line.  On success, either the cubies (*havecubies set)
+ *   or the components are filled in; text formats stop at the cubies
+ *   so the caller only ranks them if it needs to.
+ */
+int parseState(const char *line, struct cubies *cu, struct cubecoords *cc,
+               int *havecubies) {
+   const char *toks[MAXTOKS] ;
+   int itoks[MAXTOKS] ;
+   unsigned char buf[MAXTOKS] ;
+   int ntoks = 0 ;
+   const char *last = line ;
+   for (const char *p = line; *p; p++)
+      if (!iswhite(*p)) {
+         if (p == line || iswhite(p[-1])) {
+            if (ntoks >= MAXTOKS)
+               return TOO_MANY_TOKENS ;
+            toks[ntoks++] = p ;
+         }
+         last = p + 1 ;
+      }
+   int err = 0 ;
+   *havecubies = 0 ;
+   if (ntoks == 0 || ismovestring(toks[0])) {
+      perm p ;
+      iota(p) ;
+      err = domoves(p, line) ;
+      if (err == 0)
+         err = heykubeToCubies(p, cu) ;
+      *havecubies = 1 ;
+   } else if (ntoks == 4) { // has to be 4-valued coordinate values
+      err = toints(toks, ntoks, 0, 500000000, 10, itoks) ;
+      if (err)
+         return err ;
+      cc->epLex = itoks[0] ;
+      cc->eoMask = itoks[1] ;
+      cc->cpLex = itoks[2] ;
+      cc->coMask = itoks[3] ;
+      cc->poIdxU = 7 ;
+      cc->poIdxL = cc->moSupport = cc->moMask = 0 ;
+      tobytes11(cc, buf) ;
+      err = frombytes11(buf, cc) ; // use the range checking there
+   } else if (ntoks == 6) { // has to be phase coordinates
+      err = toints(toks, ntoks, 0, 40320, 10, itoks) ;
+      if (err)
+         return err ;
+      struct phasecoords pc ;
+      pc.twist = itoks[0] ;
+      pc.flip = itoks[1] ;
+      pc.slice = itoks[2] ;
+      pc.cornerPerm = itoks[3] ;
+      pc.udEdgePerm = itoks[4] ;
+      pc.slicePerm = itoks[5] ;
+      err = phaseToComponents(&pc, cc) ;
+   } else if (ntoks == 11) { // has to be 11-byte hex
+      err = toints(toks, ntoks, 0, 256, 16, itoks) ;
+      if (err)
+         return err ;
+      for (int i=0; i<11; i++)
+         buf[i] = itoks[i] ;
+      err = frombytes11(buf, cc) ;
+   } else if (ntoks == 20) { // has to be reid
+      char Reid[68] ;
+      int len = last - toks[0] ;
+      if (len >= (int)sizeof(Reid))
+         return WRONG_REID_LENGTH ;
+      memcpy(Reid, toks[0], len) ;
+      Reid[len] = 0 ;
+      err = ReidToCubies(Reid, cu) ;
+      *havecubies = 1 ;
+   } else if (ntoks == 54) { // only stickers and heykube are left
+      err = toints(toks, ntoks, 0, 54, 10, itoks) ;
+      if (err)
+         return err ;
+      int hival = 0 ;
+      for (int i=0; i<54; i++) {
+         if (itoks[i] > hival)
+            hival = itoks[i] ;
+         buf[i] = itoks[i] ;
+      }
+      if (hival == 5)
+         err = stickersToCubies(buf, cu) ;
+      else if (hival == 53)
+         err = heykubeToCubies(buf, cu) ;
+      else
+         return BAD_STICKER_VALUES ;
+      *havecubies = 1 ;
+   } else {
+      return BAD_TOKEN_COUNT ;
+   }
+   return err ;
+}
@@ -0,0 +1,9 @@
+/*
+ *   Routines exported.
+ */
+#ifndef PARSESTATE_H
+#include "cubecoords.h"
+extern int parseState(const char *line, struct cubies *cu,
+                      struct cubecoords *cc, int *havecubies) ;
+#define PARSESTATE_H
+#endif
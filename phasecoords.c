@@ -0,0 +1,207 @@
+/**
+ *   Kociemba phase coordinates from the components and back.
+ *
+ *   Kociemba numbers the edges UR UF UL UB DR DF DL DB FR FL BL BR
+ *   and the corners URF UFL ULB UBR DFR DLF DBL DRB, so the cubies
+ *   are renumbered from the Reid order before ranking.  Both use the
+ *   U/D (or, for slice edges, F/B) facelet as the orientation
+ *   reference; Reid lists corner facelets counterclockwise and
+ *   Kociemba clockwise, which works out to the same twist values.
+ *
+ *   The twist and flip are the orientations without the last corner
+ *   or edge, which is implied by the others.  The slice coordinate
+ *   ranks the set of positions holding the slice edges (solved is
+ *   0); the U and D edges and the slice edges are then ranked in the
+ *   order they appear, as is the corner permutation, with Kociemba's
+ *   rotation ranking rather than the Lehmer one in index.c.  The last
+ *   three together are just another way to write the edge
+ *   permutation, so the conversion back needs no extra information.
+ */
+#include "cubecoords.h"
+#include "phasecoords.h"
+#include "index.h"
+#include "errors.h"
+static const short binomial[12][5] = {
+   {1, 0, 0, 0, 0}, {1, 1, 0, 0, 0}, {1, 2, 1, 0, 0}, {1, 3, 3, 1, 0},
+   {1, 4, 6, 4, 1}, {1, 5, 10, 10, 5}, {1, 6, 15, 20, 15},
+   {1, 7, 21, 35, 35}, {1, 8, 28, 56, 70}, {1, 9, 36, 84, 126},
+   {1, 10, 45, 120, 210}, {1, 11, 55, 165, 330} } ;
+/*
+ *   Reid index to Kociemba index and back (each is its own inverse).
+ */
+static const unsigned char edgeToK[] = { 1, 0, 3, 2, 5, 4, 7, 6, 8, 9, 11, 10 } ;
+static const unsigned char cornerToK[] = { 0, 3, 2, 1, 4, 5, 6, 7 } ;
+/*
+ *   Kociemba's permutation rank:  from the top down, count the left
+ *   rotations of perm[0..j] that bring j into place.  perm is used up.
+ */
+static int rankRotations(unsigned char *perm, int n) {
+   int b = 0 ;
+   for (int j=n-1; j>0; j--) {
+      int k = 0 ;
+      while (perm[j] != j) {
+         unsigned char t = perm[0] ;
+         for (int i=0; i<j; i++)
+            perm[i] = perm[i+1] ;
+         perm[j] = t ;
+         k++ ;
+      }
+      b = (j + 1) * b + k ;
+   }
+   return b ;
+}
+static void unrankRotations(int b, unsigned char *perm, int n) {
+   for (int i=0; i<n; i++)
+      perm[i] = i ;
+   for (int j=1; j<n; j++) {
+      for (int k=b%(j+1); k>0; k--) {
+         unsigned char t = perm[j] ;
+         for (int i=j; i>0; i--)
+            perm[i] = perm[i-1] ;
+         perm[0] = t ;
+      }
+      b /= j + 1 ;
+   }
+}
+/*
+ *   Kociemba edge cubie at each Kociemba position to slice,
+ *   udEdgePerm and slicePerm.
+ */
+static void edgesToPhase(const unsigned char *ep, struct phasecoords *pc) {
+   unsigned char ud[8], sl[4] ;
+   int u = 8, s = 4, slice = 0 ;
+   for (int j=11; j>=0; j--)
+      if (ep[j] >= 8) {
+         slice += binomial[11-j][5-s] ;
+         sl[--s] = ep[j] - 8 ;
+      } else {
+         ud[--u] = ep[j] ;
+      }
+   pc->slice = slice ;
+   pc->udEdgePerm = rankRotations(ud, 8) ;
+   pc->slicePerm = rankRotations(sl, 4) ;
+}
+static void phaseToEdges(const struct phasecoords *pc, unsigned char *ep) {
+   unsigned char ud[8], sl[4] ;
+   unrankRotations(pc->udEdgePerm, ud, 8) ;
+   unrankRotations(pc->slicePerm, sl, 4) ;
+   int u = 0, x = 4, slice = pc->slice ;
+   for (int j=0; j<12; j++)
+      if (x > 0 && slice >= binomial[11-j][x]) {
+         slice -= binomial[11-j][x] ;
+         ep[j] = 8 + sl[4-x--] ;
+      } else {
+         ep[j] = ud[u++] ;
+      }
+}
+/*
+ *   Everything but the edge permutation, from the Reid cubies.  The
+ *   dropped corner and edge orientations must agree with the rest,
+ *   since otherwise the state cannot be recovered.
+ */
+static int cubiesToKociemba(const struct cubies *cu, unsigned char *ep,
+                            struct phasecoords *pc) {
+   unsigned char cp[8], co[8], eo[12] ;
+   for (int i=0; i<12; i++) {
+      ep[edgeToK[i]] = edgeToK[cu->e[i] >> 1] ;
+      eo[edgeToK[i]] = cu->e[i] & 1 ;
+   }
+   for (int i=0; i<8; i++) {
+      cp[cornerToK[i]] = cornerToK[cu->c[i] >> 2] ;
+      co[cornerToK[i]] = cu->c[i] & 3 ;
+   }
+   int flip = 0, parity = eo[11] ;
+   for (int i=0; i<11; i++) {
+      flip = 2 * flip + eo[i] ;
+      parity += eo[i] ;
+   }
+   int twist = 0, sum = co[7] ;
+   for (int i=0; i<7; i++) {
+      twist = 3 * twist + co[i] ;
+      sum += co[i] ;
+   }
+   if ((parity & 1) || sum % 3)
+      return UNSOLVABLE_ORIENTATION ;
+   pc->twist = twist ;
+   pc->flip = flip ;
+   pc->cornerPerm = rankRotations(cp, 8) ;
+   return 0 ;
+}
+int cubiesToPhase(const struct cubies *cu, struct phasecoords *pc) {
+   unsigned char ep[12] ;
+   int err = checkCubies(cu) ;
+   if (err == 0)
+      err = cubiesToKociemba(cu, ep, pc) ;
+   if (err == 0)
+      edgesToPhase(ep, pc) ;
+   return err ;
+}
+int componentsToPhase(const struct cubecoords *cc, struct phasecoords *pc) {
+   struct cubies cu ;
+   int err = componentsToCubies(cc, &cu) ;
+   if (err == 0)
+      err = cubiesToPhase(&cu, pc) ;
+   return err ;
+}
+int phaseToComponents(const struct phasecoords *pc, struct cubecoords *cc) {
+   unsigned char ep[12], cp[8] ;
+   struct cubies cu ;
+   if (pc->twist < 0 || pc->twist >= 2187)
+      return CORNER_ORIENTATION_OUT_OF_RANGE ;
+   if (pc->flip < 0 || pc->flip >= 2048)
+      return EDGE_ORIENTATION_OUT_OF_RANGE ;
+   if (pc->cornerPerm < 0 || pc->cornerPerm >= 40320)
+      return CORNER_PERMUTATION_OUT_OF_RANGE ;
+   if (pc->slice < 0 || pc->slice >= 495 ||
+       pc->udEdgePerm < 0 || pc->udEdgePerm >= 40320 ||
+       pc->slicePerm < 0 || pc->slicePerm >= 24)
+      return EDGE_PERMUTATION_OUT_OF_RANGE ;
+   phaseToEdges(pc, ep) ;
+   unrankRotations(pc->cornerPerm, cp, 8) ;
+   int parity = 0 ;
+   for (int i=10, f=pc->flip; i>=0; i--, f >>= 1) {
+      cu.e[edgeToK[i]] = 2 * edgeToK[ep[i]] + (f & 1) ;
+      parity += f & 1 ;
+   }
+   cu.e[edgeToK[11]] = 2 * edgeToK[ep[11]] + (parity & 1) ;
+   int sum = 0 ;
+   for (int i=6, t=pc->twist; i>=0; i--, t /= 3) {
+      cu.c[cornerToK[i]] = 4 * cornerToK[cp[i]] + t % 3 ;
+      sum += t % 3 ;
+   }
+   cu.c[cornerToK[7]] = 4 * cornerToK[cp[7]] + (3 - sum % 3) % 3 ;
+   return cubiesToComponents(&cu, cc) ;
+}
+/*
+ *   Bulk form over columns.  Bit i&7 of errbits[i>>3] is set if
+ *   record i has an unsolvable orientation; the count of such
+ *   records is returned.
+ */
+int componentsToPhaseBulk(const int *epLex, const int *eoMask,
+                      const int *cpLex, const int *coMask, int n,
+                      int *twist, int *flip, int *slice, int *cornerPerm,
+                      int *udEdgePerm, int *slicePerm,
+                      unsigned char *errbits) {
+   int bad = 0 ;
+   for (int i=0; i<n; i++) {
+      struct cubecoords cc ;
+      struct phasecoords pc = { 0, 0, 0, 0, 0, 0 } ;
+      cc.epLex = epLex[i] ;
+      cc.eoMask = eoMask[i] ;
+      cc.cpLex = cpLex[i] ;
+      cc.coMask = coMask[i] ;
+      if ((i & 7) == 0)
+         errbits[i>>3] = 0 ;
+      if (componentsToPhase(&cc, &pc) != 0) {
+         errbits[i>>3] |= 1 << (i & 7) ;
+         bad++ ;
+      }
+      twist[i] = pc.twist ;
+      flip[i] = pc.flip ;
+      slice[i] = pc.slice ;
+      cornerPerm[i] = pc.cornerPerm ;
+      udEdgePerm[i] = pc.udEdgePerm ;
+      slicePerm[i] = pc.slicePerm ;
+   }
+   return bad ;
+}
@@ -0,0 +1,32 @@
+/*
+ *   The coordinates of the two phases of Kociemba's algorithm, with
+ *   his numbering, so they index the move and pruning tables of a
+ *   standard two-phase solver.  udEdgePerm and slicePerm are his
+ *   phase-2 U/D edge and sorted slice coordinates; for states outside
+ *   phase 2 we rank the edges in the order they appear.
+ */
+#ifndef PHASECOORDS_H
+#include "cubecoords.h"
+struct phasecoords {
+   int twist ;      /* corner orientation of the first 7; 0..2186 */
+   int flip ;       /* edge orientation of the first 11; 0..2047 */
+   int slice ;      /* positions of the slice edges; 0..494 */
+   int cornerPerm ; /* corner permutation; 0..40319 */
+   int udEdgePerm ; /* order of the eight U and D edges; 0..40319 */
+   int slicePerm ;  /* order of the four slice edges; 0..23 */
+} ;
+/*
+ *   Routines in phasecoords.c
+ */
+extern int componentsToPhase(const struct cubecoords *cc,
+                             struct phasecoords *pc) ;
+extern int cubiesToPhase(const struct cubies *cu, struct phasecoords *pc) ;
+extern int phaseToComponents(const struct phasecoords *pc,
+                             struct cubecoords *cc) ;
+extern int componentsToPhaseBulk(const int *epLex, const int *eoMask,
+                      const int *cpLex, const int *coMask, int n,
+                      int *twist, int *flip, int *slice, int *cornerPerm,
+                      int *udEdgePerm, int *slicePerm,
+                      unsigned char *errbits) ;
+#define PHASECOORDS_H
+#endif
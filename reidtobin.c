@@ -3,11 +3,15 @@
  *   3x3x3 binary representation, and back again.
  */
 #include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 #include "heykubetobin.h"
-#include "index.h"
+#include "reidtobin.h"
 #include "errors.h"
 static const char *solved =
    "UF UR UB UL DF DR DB DL FR FL BR BL UFR URB UBL ULF DRF DFL DLB DBR" ;
+#define REIDLEN 67
 /*
  *   To initialize, we want a table that goes from cubie coloring
  *   back to actual cubies and forward to cubie coloring.  We separate
@@ -81,75 +85,109 @@ static const unsigned short cornerExpand[] = {21714, 6741, 19110, 0, 22082,
    18628, 6290, 0, 4300, 6532, 12422, 0, 4482, 12356, 2188, 0, 4178, 2628,
    18562, 0 } ;
 #endif
+#ifdef __SSE2__
 /*
- *   From an array of cubie values, calculate the relevant
- *   permutations and orientations.  Ensure all needed cubies are seen.
+ *   Check the characters and hash each adjacent pair 16 positions at
+ *   a time.  The chunks overlap at the end so that we never read past
+ *   the terminating null; spaceMask gives where the separators are.
  */
-int ReidToComponents(const char *Reid, struct cubecoords *cc) {
-   initializeReidTable() ;
-   unsigned char perm[12] ;
-   int edgeo = 0 ;
-   int cornero = 0 ;
-   if (strlen(solved) != strlen(Reid))
-      return WRONG_REID_LENGTH ;
+static const int chunkStart[] = { 0, 16, 32, 48, 51 } ;
+static const int spaceMask[] = { 0x4924, 0x2492, 0x8889, 0x8888, 0x1111 } ;
+static int scanReid(const char *Reid, unsigned char *hash) {
+   for (int k=0; k<5; k++) {
+      __m128i v = _mm_loadu_si128((const __m128i *)(Reid+chunkStart[k])) ;
+      __m128i w = _mm_loadu_si128((const __m128i *)(Reid+chunkStart[k]+1)) ;
+      __m128i faces = _mm_or_si128(
+         _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('U')),
+                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('F'))),
+                      _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('R')),
+                                   _mm_cmpeq_epi8(v, _mm_set1_epi8('D')))),
+         _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('B')),
+                      _mm_cmpeq_epi8(v, _mm_set1_epi8('L')))) ;
+      __m128i spaces = _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')) ;
+      if (_mm_movemask_epi8(spaces) != spaceMask[k] ||
+          _mm_movemask_epi8(_mm_or_si128(faces, spaces)) != 0xffff)
+         return REID_ELEMENT_OUT_OF_RANGE ;
+      // (v + 15 * w) & 63, as v + (w << 4) - w in byte lanes
+      __m128i w16 = _mm_and_si128(_mm_slli_epi16(w, 4),
+                                  _mm_set1_epi8((char)0xf0)) ;
+      __m128i h = _mm_and_si128(_mm_sub_epi8(_mm_add_epi8(v, w16), w),
+                                _mm_set1_epi8(63)) ;
+      _mm_storeu_si128((__m128i *)(hash+chunkStart[k]), h) ;
+   }
+   return 0 ;
+}
+#else
+static int scanReid(const char *Reid, unsigned char *hash) {
    for (int i=0; solved[i]; i++)
       if (solved[i] != Reid[i] && (solved[i] == ' ' ||
            (Reid[i] != 'U' && Reid[i] != 'F' && Reid[i] != 'R' &&
             Reid[i] != 'D' && Reid[i] != 'B' && Reid[i] != 'L')))
          return REID_ELEMENT_OUT_OF_RANGE ;
+   for (int i=0; i<12; i++)
+      hash[3*i] = (Reid[3*i]+15*Reid[3*i+1])&63 ;
+   for (int i=0; i<8; i++)
+      hash[36+4*i] = (Reid[36+4*i]+15*Reid[37+4*i])&63 ;
+   return 0 ;
+}
+#endif
+/*
+ *   From a Reid string, find the cubie in each position.  Ensure
+ *   every cubie is legal.
+ */
+int ReidToCubies(const char *Reid, struct cubies *cu) {
+   initializeReidTable() ;
+   unsigned char hash[REIDLEN+1] ;
+   if (strlen(Reid) != REIDLEN)
+      return WRONG_REID_LENGTH ;
+   int err = scanReid(Reid, hash) ;
+   if (err)
+      return err ;
    for (int i=0; i<12; i++) {
-      int cubie = edgeLookup[(Reid[3*i]+15*Reid[3*i+1])&63] ;
+      int cubie = edgeLookup[hash[3*i]] ;
       if (cubie == 255 ||
           edgeExpand[cubie] != ((Reid[3*i]&31) << 5) + (Reid[3*i+1]&31))
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = cubie >> 1 ;
-      edgeo = 2 * edgeo + (cubie & 1) ;
+      cu->e[i] = cubie ;
    }
-   int edgeperm = encodePerm(perm, 12) ;
-   if (edgeperm < 0)
-      return MISSING_EDGE_CUBIE ;
    for (int i=0; i<8; i++) {
-      int cubie = cornerLookup[(Reid[36+4*i]+15*Reid[37+4*i])&63] ;
+      int cubie = cornerLookup[hash[36+4*i]] ;
       if (cubie == 255 || cornerExpand[cubie] != ((Reid[36+4*i]&31) << 10) +
                                ((Reid[37+4*i]&31) << 5) + (Reid[38+4*i]&31))
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = (cubie >> 2) ;
-      cornero = 3 * cornero + (cubie & 3) ;
+      cu->c[i] = cubie ;
    }
-   int cornerperm = encodePerm(perm, 8) ;
-   if (cornerperm < 0)
-      return MISSING_CORNER_CUBIE ;
-   cc->cpLex = cornerperm ;
-   cc->coMask = cornero ;
-   cc->poIdxU = 7 ;
-   cc->epLex = edgeperm ;
-   cc->poIdxL = 0 ;
-   cc->moSupport = 0 ;
-   cc->eoMask = edgeo ;
-   cc->moMask = 0 ;
    return 0 ;
 }
-int componentsToReid(const struct cubecoords *cc, char *Reid) {
+int cubiesToReid(const struct cubies *cu, char *Reid) {
    initializeReidTable() ;
-   unsigned char perm[12] ;
-   for (int i=0; solved[i]; i++)
-      Reid[i] = ' ' ;
-   Reid[strlen(solved)] = 0 ;
-   int eo = cc->eoMask ;
-   decodePerm(cc->epLex, perm, 12) ;
+   memcpy(Reid, solved, REIDLEN+1) ; // separators and terminator in one go
    for (int i=0; i<12; i++) {
-      int colors = edgeExpand[2*perm[i]+(1&(eo>>(11-i)))] ;
+      int colors = edgeExpand[cu->e[i]] ;
       Reid[3*i] = '@'+(colors>>5) ;
       Reid[3*i+1] = '@'+(colors&31) ;
    }
-   decodePerm(cc->cpLex, perm, 8) ;
-   int co = cc->coMask ;
-   for (int i=7; i>=0; i--) {
-      int colors = cornerExpand[4*perm[i]+(co%3)] ;
+   for (int i=0; i<8; i++) {
+      int colors = cornerExpand[cu->c[i]] ;
       Reid[36+4*i] = '@'+(colors>>10) ;
       Reid[37+4*i] = '@'+((colors>>5)&31) ;
       Reid[38+4*i] = '@'+(colors&31) ;
-      co /= 3 ;
    }
    return 0 ;
 }
+/*
+ *   From an array of cubie values, calculate the relevant
+ *   permutations and orientations.  Ensure all needed cubies are seen.
+ */
+int ReidToComponents(const char *Reid, struct cubecoords *cc) {
+   struct cubies cu ;
+   int err = ReidToCubies(Reid, &cu) ;
+   if (err == 0)
+      err = cubiesToComponents(&cu, cc) ;
+   return err ;
+}
+int componentsToReid(const struct cubecoords *cc, char *Reid) {
+   struct cubies cu ;
+   componentsToCubies(cc, &cu) ;
+   return cubiesToReid(&cu, Reid) ;
+}
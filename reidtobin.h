@@ -4,3 +4,5 @@
 #include "stickerstobin.h"
 extern int ReidToComponents(const char *Reid, struct cubecoords *cc) ;
 extern int componentsToReid(const struct cubecoords *cc, char *Reid) ;
+extern int ReidToCubies(const char *Reid, struct cubies *cu) ;
+extern int cubiesToReid(const struct cubies *cu, char *Reid) ;
@@ -0,0 +1,415 @@
+/**
+ *   Sort and deduplicate a stream of packed 11-byte records (as
+ *   written by tobytes11) that may be much larger than memory.
+ *
+ *   The input is read in runs that fill half the memory budget; the
+ *   other half is the scatter target.  Each run is sorted with a
+ *   parallel MSD radix sort:  the threads histogram and scatter the
+ *   first byte together, then take the 256 first-byte buckets as they
+ *   come free and finish each with an in-place (American flag) radix
+ *   sort on the remaining bytes.  Sorted runs are deduplicated and
+ *   appended to a temporary file in $TMPDIR, then merged k ways with
+ *   a heap, deduplicating again on the way out.  The merge width is
+ *   capped so each run still gets a large read buffer; with more runs
+ *   than that, groups are merged into a new temporary file first.  If
+ *   the whole input fits in one run it goes straight to the output.
+ *
+ *   Records are compared as plain bytes, which is the same order as
+ *   the components themselves.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "batch.h"
+#include "sortrecs.h"
+#include "errors.h"
+#define RECSZ 11
+#define SMALLSORT 32           // insertion sort below this many records
+#define MINRUN 4096            // smallest run we will bother with
+#define MERGEBUF (1 << 20)      // smallest read buffer per run in a merge
+#define MAXMERGE 1024          // most runs merged at once
+static void insertionSort(unsigned char *a, long n, int d) {
+   unsigned char t[RECSZ] ;
+   for (long i=1; i<n; i++) {
+      long j = i ;
+      memcpy(t, a+i*RECSZ, RECSZ) ;
+      while (j > 0 && memcmp(a+(j-1)*RECSZ+d, t+d, RECSZ-d) > 0) {
+         memcpy(a+j*RECSZ, a+(j-1)*RECSZ, RECSZ) ;
+         j-- ;
+      }
+      memcpy(a+j*RECSZ, t, RECSZ) ;
+   }
+}
+/*
+ *   In-place MSD radix sort of n records on bytes d and up.
+ */
+static void flagSort(unsigned char *a, long n, int d) {
+   if (n < SMALLSORT) {
+      insertionSort(a, n, d) ;
+      return ;
+   }
+   long cnt[256], head[256], tail[256] ;
+   memset(cnt, 0, sizeof(cnt)) ;
+   for (long i=0; i<n; i++)
+      cnt[a[i*RECSZ+d]]++ ;
+   long s = 0 ;
+   for (int b=0; b<256; b++) {
+      head[b] = s ;
+      s += cnt[b] ;
+      tail[b] = s ;
+   }
+   unsigned char t[RECSZ] ;
+   for (int b=0; b<256; b++) {
+      while (head[b] < tail[b]) {
+         unsigned char *p = a + head[b] * RECSZ ;
+         int v = p[d] ;
+         if (v == b) {
+            head[b]++ ;
+         } else {
+            unsigned char *q = a + head[v]++ * RECSZ ;
+            memcpy(t, q, RECSZ) ;
+            memcpy(q, p, RECSZ) ;
+            memcpy(p, t, RECSZ) ;
+         }
+      }
+   }
+   if (d + 1 < RECSZ)
+      for (int b=0; b<256; b++)
+         if (cnt[b] > 1)
+            flagSort(a + (tail[b] - cnt[b]) * RECSZ, cnt[b], d+1) ;
+}
+/*
+ *   Shared state for sorting one run with several threads.
+ */
+struct sortJob {
+   const unsigned char *src ;
+   unsigned char *dst ;
+   long n ;
+   long (*counts)[256] ;       // per thread first-byte counts, then offsets
+   long bucket[257] ;          // start of each first-byte bucket in dst
+   int nextBucket ;
+   pthread_mutex_t lock ;
+} ;
+static void countSlice(void *arg, int t, int nt) {
+   struct sortJob *job = arg ;
+   long lo = job->n * t / nt ;
+   long hi = job->n * (t + 1) / nt ;
+   long *cnt = job->counts[t] ;
+   memset(cnt, 0, 256 * sizeof(long)) ;
+   for (long i=lo; i<hi; i++)
+      cnt[job->src[i*RECSZ]]++ ;
+}
+static void scatterSlice(void *arg, int t, int nt) {
+   struct sortJob *job = arg ;
+   long lo = job->n * t / nt ;
+   long hi = job->n * (t + 1) / nt ;
+   long *off = job->counts[t] ;
+   for (long i=lo; i<hi; i++) {
+      const unsigned char *p = job->src + i * RECSZ ;
+      memcpy(job->dst + off[*p]++ * RECSZ, p, RECSZ) ;
+   }
+}
+static void sortBuckets(void *arg, int t, int nt) {
+   struct sortJob *job = arg ;
+   (void)t ;
+   (void)nt ;
+   for (;;) {
+      pthread_mutex_lock(&job->lock) ;
+      int b = job->nextBucket++ ;
+      pthread_mutex_unlock(&job->lock) ;
+      if (b >= 256)
+         return ;
+      long n = job->bucket[b+1] - job->bucket[b] ;
+      if (n > 1)
+         flagSort(job->dst + job->bucket[b] * RECSZ, n, 1) ;
+   }
+}
+/*
+ *   Sort n records from src into dst using nthreads threads.
+ */
+static int sortRun(const unsigned char *src, unsigned char *dst, long n,
+                   int nthreads) {
+   struct sortJob job ;
+   job.src = src ;
+   job.dst = dst ;
+   job.n = n ;
+   job.nextBucket = 0 ;
+   job.counts = malloc(nthreads * sizeof(*job.counts)) ;
+   if (job.counts == 0)
+      return OUT_OF_MEMORY ;
+   pthread_mutex_init(&job.lock, 0) ;
+   runThreads(nthreads, countSlice, &job) ;
+   long s = 0 ;
+   for (int b=0; b<256; b++) {
+      job.bucket[b] = s ;
+      for (int t=0; t<nthreads; t++) {
+         long c = job.counts[t][b] ;
+         job.counts[t][b] = s ;
+         s += c ;
+      }
+   }
+   job.bucket[256] = s ;
+   runThreads(nthreads, scatterSlice, &job) ;
+   runThreads(nthreads, sortBuckets, &job) ;
+   pthread_mutex_destroy(&job.lock) ;
+   free(job.counts) ;
+   return 0 ;
+}
+/*
+ *   Squeeze out adjacent duplicates in place; return the new count.
+ */
+static long dedupe(unsigned char *a, long n) {
+   if (n == 0)
+      return 0 ;
+   long m = 1 ;
+   for (long i=1; i<n; i++)
+      if (memcmp(a+i*RECSZ, a+(m-1)*RECSZ, RECSZ) != 0) {
+         if (m != i)
+            memcpy(a+m*RECSZ, a+i*RECSZ, RECSZ) ;
+         m++ ;
+      }
+   return m ;
+}
+static FILE *spillFile(void) {
+   char name[4096] ;
+   const char *dir = getenv("TMPDIR") ;
+   if (dir == 0 || *dir == 0)
+      dir = "/tmp" ;
+   snprintf(name, sizeof(name), "%s/cubesortXXXXXX", dir) ;
+   int fd = mkstemp(name) ;
+   if (fd < 0)
+      return 0 ;
+   unlink(name) ;
+   FILE *f = fdopen(fd, "w+b") ;
+   if (f == 0)
+      close(fd) ;
+   return f ;
+}
+/*
+ *   Read up to cap records; return the count or an error.
+ */
+static long readRecords(FILE *in, unsigned char *a, long cap) {
+   size_t got = 0 ;
+   size_t want = cap * RECSZ ;
+   while (got < want) {
+      size_t r = fread(a+got, 1, want-got, in) ;
+      if (r == 0)
+         break ;
+      got += r ;
+   }
+   if (ferror(in))
+      return IO_ERROR ;
+   if (got % RECSZ)
+      return PARTIAL_RECORD ;
+   return got / RECSZ ;
+}
+/*
+ *   One spilled run being merged.  All the runs of a pass share one
+ *   spill file and are read with pread at their own offsets, so the
+ *   number of runs is not limited by open files.
+ */
+struct mergeRun {
+   int fd ;
+   long long next ;            // next record to read
+   long long end ;             // one past the last record
+   unsigned char *buf ;
+   long n ;
+   long pos ;
+} ;
+static int refill(struct mergeRun *r, long cap) {
+   long n = r->end - r->next < cap ? r->end - r->next : cap ;
+   size_t want = n * RECSZ ;
+   size_t got = 0 ;
+   while (got < want) {
+      ssize_t k = pread(r->fd, r->buf + got, want - got,
+                        r->next * RECSZ + got) ;
+      if (k <= 0)
+         return IO_ERROR ;
+      got += k ;
+   }
+   r->next += n ;
+   r->n = n ;
+   r->pos = 0 ;
+   return 0 ;
+}
+static const unsigned char *head(const struct mergeRun *r) {
+   return r->buf + r->pos * RECSZ ;
+}
+static void siftDown(struct mergeRun **heap, int n, int i) {
+   for (;;) {
+      int c = 2 * i + 1 ;
+      if (c >= n)
+         return ;
+      if (c + 1 < n && memcmp(head(heap[c+1]), head(heap[c]), RECSZ) < 0)
+         c++ ;
+      if (memcmp(head(heap[c]), head(heap[i]), RECSZ) >= 0)
+         return ;
+      struct mergeRun *t = heap[c] ;
+      heap[c] = heap[i] ;
+      heap[i] = t ;
+      i = c ;
+   }
+}
+/*
+ *   Merge the nruns runs of spill starting at the record offsets in
+ *   bounds (nruns+1 entries) onto out, deduplicating; the number of
+ *   records written is stored in *written.
+ */
+static int mergeRuns(FILE *spill, const long long *bounds, int nruns,
+                     FILE *out, long long membytes, long long *written) {
+   long cap = membytes / ((nruns + 1) * (long long)RECSZ) ;
+   if (cap < MERGEBUF / RECSZ)
+      cap = MERGEBUF / RECSZ ;
+   struct mergeRun *runs = calloc(nruns, sizeof(*runs)) ;
+   struct mergeRun **heap = calloc(nruns, sizeof(*heap)) ;
+   unsigned char *obuf = malloc(cap * RECSZ) ;
+   int err = (runs && heap && obuf) ? 0 : OUT_OF_MEMORY ;
+   if (err == 0 && fflush(spill) != 0)
+      err = IO_ERROR ;
+   int nheap = 0 ;
+   for (int i=0; err == 0 && i<nruns; i++) {
+      runs[i].fd = fileno(spill) ;
+      runs[i].next = bounds[i] ;
+      runs[i].end = bounds[i+1] ;
+      runs[i].buf = malloc(cap * RECSZ) ;
+      if (runs[i].buf == 0)
+         err = OUT_OF_MEMORY ;
+      else
+         err = refill(&runs[i], cap) ;
+      if (err == 0 && runs[i].n > 0)
+         heap[nheap++] = &runs[i] ;
+   }
+   for (int i=nheap/2-1; i>=0; i--)
+      siftDown(heap, nheap, i) ;
+   unsigned char last[RECSZ] ;
+   long on = 0 ;
+   int any = 0 ;
+   *written = 0 ;
+   while (err == 0 && nheap > 0) {
+      struct mergeRun *r = heap[0] ;
+      if (!any || memcmp(last, head(r), RECSZ) != 0) {
+         if (on == cap) {
+            if (fwrite(obuf, RECSZ, on, out) != (size_t)on)
+               err = IO_ERROR ;
+            on = 0 ;
+         }
+         memcpy(obuf+on*RECSZ, head(r), RECSZ) ;
+         memcpy(last, head(r), RECSZ) ;
+         on++ ;
+         (*written)++ ;
+         any = 1 ;
+      }
+      if (++r->pos == r->n) {
+         int e = refill(r, cap) ;
+         if (e)
+            err = e ;
+         else if (r->n == 0)
+            heap[0] = heap[--nheap] ;
+      }
+      siftDown(heap, nheap, 0) ;
+   }
+   if (err == 0 && fwrite(obuf, RECSZ, on, out) != (size_t)on)
+      err = IO_ERROR ;
+   for (int i=0; runs && i<nruns; i++)
+      free(runs[i].buf) ;
+   free(runs) ;
+   free(heap) ;
+   free(obuf) ;
+   return err ;
+}
+/*
+ *   Merge groups of width runs into a new spill file until at most
+ *   width are left, so every read buffer stays at least MERGEBUF.
+ */
+static int mergePasses(FILE **spill, long long *bounds, int *nruns,
+                       int width, long long membytes) {
+   int err = 0 ;
+   while (err == 0 && *nruns > width) {
+      FILE *next = spillFile() ;
+      if (next == 0)
+         return IO_ERROR ;
+      int m = 0 ;
+      for (int i=0; err == 0 && i<*nruns; i+=width) {
+         int k = *nruns - i < width ? *nruns - i : width ;
+         long long written ;
+         err = mergeRuns(*spill, bounds+i, k, next, membytes, &written) ;
+         bounds[m+1] = bounds[m] + written ;
+         m++ ;
+      }
+      fclose(*spill) ;
+      *spill = next ;
+      *nruns = m ;
+   }
+   return err ;
+}
+/*
+ *   Sort and dedupe all records from in onto out, using about
+ *   membytes of memory and nthreads threads (0 for one per CPU).
+ */
+int sortRecords11(FILE *in, FILE *out, long long membytes, int nthreads) {
+   nthreads = threadCount(nthreads) ;
+   long cap = membytes / (2 * RECSZ) ;
+   if (cap < MINRUN)
+      cap = MINRUN ;
+   int width = membytes / MERGEBUF - 1 ;
+   if (width < 2)
+      width = 2 ;
+   if (width > MAXMERGE)
+      width = MAXMERGE ;
+   unsigned char *src = malloc(cap * RECSZ) ;
+   unsigned char *dst = malloc(cap * RECSZ) ;
+   FILE *spill = 0 ;
+   long long *bounds = malloc(sizeof(long long)) ;
+   int nruns = 0 ;
+   int err = (src && dst && bounds) ? 0 : OUT_OF_MEMORY ;
+   if (bounds)
+      bounds[0] = 0 ;
+   while (err == 0) {
+      long got = readRecords(in, src, cap) ;
+      if (got < 0) {
+         err = got ;
+         break ;
+      }
+      if (got == 0 && nruns > 0)
+         break ;
+      err = sortRun(src, dst, got, got < MINRUN ? 1 : nthreads) ;
+      if (err)
+         break ;
+      long n = dedupe(dst, got) ;
+      if (nruns == 0 && got < cap) { // all fit in one run
+         if (fwrite(dst, RECSZ, n, out) != (size_t)n)
+            err = IO_ERROR ;
+         break ;
+      }
+      long long *t = realloc(bounds, (nruns + 2) * sizeof(long long)) ;
+      if (t == 0) {
+         err = OUT_OF_MEMORY ;
+         break ;
+      }
+      bounds = t ;
+      if (spill == 0 && (spill = spillFile()) == 0) {
+         err = IO_ERROR ;
+         break ;
+      }
+      if (fwrite(dst, RECSZ, n, spill) != (size_t)n)
+         err = IO_ERROR ;
+      bounds[nruns+1] = bounds[nruns] + n ;
+      nruns++ ;
+   }
+   free(src) ;
+   free(dst) ;
+   if (err == 0 && nruns > 0)
+      err = mergePasses(&spill, bounds, &nruns, width, membytes) ;
+   if (err == 0 && nruns > 0) {
+      long long written ;
+      err = mergeRuns(spill, bounds, nruns, out, membytes, &written) ;
+   }
+   if (spill)
+      fclose(spill) ;
+   free(bounds) ;
+   if (err == 0 && fflush(out) != 0)
+      err = IO_ERROR ;
+   return err ;
+}
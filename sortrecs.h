@@ -0,0 +1,9 @@
+/*
+ *   Routines exported.
+ */
+#ifndef SORTRECS_H
+#include <stdio.h>
+extern int sortRecords11(FILE *in, FILE *out, long long membytes,
+                         int nthreads) ;
+#define SORTRECS_H
+#endif
@@ -32,7 +32,6 @@ UF UR UB UL DF DR DB DL FR FL BR BL UFR URB UBL ULF DRF DFL DLB DBR U L F R B D
  */
 #include "cubecoords.h"
 #include "stickerstobin.h"
-#include "index.h"
 #include "errors.h"
 static const unsigned char ReidOrder[] = {
     7,19,  5,28,  1,37,  3,10            , // up edges
@@ -99,14 +98,11 @@ static const unsigned short cornerExpand[] = { 19, 152, 194, 0, 28, 224,
    0, 332, 101, 297, 0, 355, 285, 236, 0,} ;
 #endif
 /*
- *   From an array of cubie values, calculate the relevant
- *   permutations and orientations.  Ensure all needed cubies are seen.
+ *   From an array of sticker values, find the cubie in each position.
+ *   Ensure every cubie is legal and the centers are in place.
  */
-int stickersToComponents(const unsigned char *stickers, struct cubecoords *cc) {
+int stickersToCubies(const unsigned char *stickers, struct cubies *cu) {
    initializeCubieTable() ;
-   unsigned char perm[12] ;
-   int edgeo = 0 ;
-   int cornero = 0 ;
    for (int i=0; i<54; i++)
       if (stickers[i] > 5)
          return STICKER_ELEMENT_OUT_OF_RANGE ;
@@ -115,58 +111,51 @@ int stickersToComponents(const unsigned char *stickers, struct cubecoords *cc) {
                                stickers[ReidOrder[2*i+1]]] ;
       if (cubie == 255)
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = cubie >> 1 ;
-      edgeo = 2 * edgeo + (cubie & 1) ;
+      cu->e[i] = cubie ;
    }
-   int edgeperm = encodePerm(perm, 12) ;
-   if (edgeperm < 0)
-      return MISSING_EDGE_CUBIE ;
    for (int i=0; i<8; i++) {
       int cubie = cornerLookup[6*stickers[ReidOrder[3*i+24]]+
                                  stickers[ReidOrder[3*i+25]]] ;
       if (cubie == 255 ||
           (cornerExpand[cubie] & 7) != stickers[ReidOrder[3*i+26]])
          return ILLEGAL_CUBIE_SEEN ;
-      perm[i] = (cubie >> 2) ;
-      cornero = 3 * cornero + (cubie & 3) ;
+      cu->c[i] = cubie ;
    }
-   int cornerperm = encodePerm(perm, 8) ;
-   if (cornerperm < 0)
-      return MISSING_CORNER_CUBIE ;
    for (int i=0; i<6; i++)
-      perm[i] = stickers[ReidOrder[i+48]] ;
-   if (encodePerm(perm, 6) != 0)
-      return PUZZLE_ORIENTATION_NOT_SUPPORTED ;
-   cc->cpLex = cornerperm ;
-   cc->coMask = cornero ;
-   cc->poIdxU = 7 ;
-   cc->epLex = edgeperm ;
-   cc->poIdxL = 0 ;
-   cc->moSupport = 0 ;
-   cc->eoMask = edgeo ;
-   cc->moMask = 0 ;
+      if (stickers[ReidOrder[i+48]] != i)
+         return PUZZLE_ORIENTATION_NOT_SUPPORTED ;
    return 0 ;
 }
-int componentsToStickers(const struct cubecoords *cc, unsigned char *stickers) {
+int cubiesToStickers(const struct cubies *cu, unsigned char *stickers) {
    initializeCubieTable() ;
-   unsigned char perm[12] ;
-   int eo = cc->eoMask ;
-   decodePerm(cc->epLex, perm, 12) ;
    for (int i=0; i<12; i++) {
-      int colors = edgeExpand[2*perm[i]+(1&(eo>>(11-i)))] ;
+      int colors = edgeExpand[cu->e[i]] ;
       stickers[ReidOrder[2*i]] = colors >> 3 ;
       stickers[ReidOrder[2*i+1]] = colors & 7 ;
    }
-   decodePerm(cc->cpLex, perm, 8) ;
-   int co = cc->coMask ;
-   for (int i=7; i>=0; i--) {
-      int colors = cornerExpand[4*perm[i]+(co%3)] ;
+   for (int i=0; i<8; i++) {
+      int colors = cornerExpand[cu->c[i]] ;
       stickers[ReidOrder[3*i+24]] = colors >> 6 ;
       stickers[ReidOrder[3*i+25]] = (colors >> 3) & 7 ;
       stickers[ReidOrder[3*i+26]] = colors & 7 ;
-      co /= 3 ;
    }
    for (int i=0; i<6; i++)
       stickers[ReidOrder[i+48]] = i ;
    return 0 ;
 }
+/*
+ *   From an array of cubie values, calculate the relevant
+ *   permutations and orientations.  Ensure all needed cubies are seen.
+ */
+int stickersToComponents(const unsigned char *stickers, struct cubecoords *cc) {
+   struct cubies cu ;
+   int err = stickersToCubies(stickers, &cu) ;
+   if (err == 0)
+      err = cubiesToComponents(&cu, cc) ;
+   return err ;
+}
+int componentsToStickers(const struct cubecoords *cc, unsigned char *stickers) {
+   struct cubies cu ;
+   componentsToCubies(cc, &cu) ;
+   return cubiesToStickers(&cu, stickers) ;
+}
@@ -10,6 +10,10 @@ extern int stickersToComponents(const unsigned char *stickers,
                                 struct cubecoords *cc) ;
 extern int componentsToStickers(const struct cubecoords *cc,
                                 unsigned char *stickers) ;
+extern int stickersToCubies(const unsigned char *stickers,
+                            struct cubies *cu) ;
+extern int cubiesToStickers(const struct cubies *cu,
+                            unsigned char *stickers) ;
 extern int encodePerm(const unsigned char *a, int n) ;
 extern void decodePerm(int lex, unsigned char *a, int n) ;
 #define STICKERSTOBIN_H
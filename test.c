@@ -1,13 +1,56 @@
 /*
  *   Test things.  Run with
  *
- *   ./stickerstobin [-b] [-c] [-h] [-s] [-R] [-v] < input > output
+ *   ./stickerstobin [-b] [-c] [-h] [-k] [-s] [-R] [-v] < input > output
  *
  *   Input is auto-detected amongst binary, component, heycube,
- *   sticker, and Reid format.  The options -b, -c, -h, -s, and -R
- *   select binary, component, heycube, sticker, and Reid format for
- *   output; more than one can be selected.  The -v option turns on
- *   verbose mode.
+ *   sticker, Reid, and Kociemba phase coordinate format.  The options
+ *   -b, -c, -h, -s, and -R select binary, component, heycube, sticker,
+ *   and Reid format for output, and -k the phase coordinates (twist,
+ *   flip, slice, corner permutation, U and D edge permutation, slice
+ *   permutation); more than one can be selected.  The -v option turns
+ *   on verbose mode.
+ *
+ *   ./stickerstobin -S [-m<megabytes>] [-t<threads>] < input > output
+ *
+ *   Sort and deduplicate packed 11-byte binary records, using about
+ *   the given amount of memory (default 256) and number of threads
+ *   (default one per CPU); input may be larger than memory.
+ *
+ *   ./stickerstobin -i < states > moves
+ *
+ *   Read a stream of states in any input format and, for each state
+ *   after the first, write the moves (at most two) that connect it to
+ *   the previous one; an empty line means no change, and "gap" means
+ *   more moves were made than we can recognize without a search.  A
+ *   sample that cannot be read gives "error" and an error code, and
+ *   the next good state starts the stream over.
+ *
+ *   ./stickerstobin -V [-t<threads>] < pairs > results
+ *
+ *   Verify solutions.  Each input line is a state in any input format,
+ *   a vertical bar, and a move sequence; each output line is "pass" or
+ *   "fail" and the number of moves, or "error" and an error code.
+ *
+ *   ./stickerstobin -C [-P] < states > container
+ *   ./stickerstobin -X [-P] [-b] [-c] [-h] [-s] [-R] < container > states
+ *
+ *   Write states in any input format to a compressed columnar
+ *   container, or read one back in the selected output formats.  With
+ *   -P the states are packed 11-byte binary records instead of text.
+ *
+ *   ./stickerstobin -M < moves > moves
+ *
+ *   Simplify each line's move sequence to a canonical form:  moves of
+ *   the same face are merged and moves of opposite faces commute, so
+ *   cancellations across them are found.  A line that cannot be
+ *   simplified gives "error" and an error code.
+ *
+ *   ./stickerstobin -A[<features>] [-P] [-t<threads>] < states > counts
+ *
+ *   Print histograms of per-state features (a comma separated list
+ *   of flip, twist, solved, parity, codist, eodist, pdb; default all)
+ *   over states in any input format, or packed records with -P.
  */
 #include <stdio.h>
 #include <stdlib.h>
@@ -16,36 +59,184 @@
 #include "stickerstobin.h"
 #include "heykubetobin.h"
 #include "reidtobin.h"
+#include "directconvert.h"
+#include "phasecoords.h"
 #include "moves.h"
+#include "sortrecs.h"
+#include "parsestate.h"
+#include "batch.h"
+#include "verify.h"
+#include "container.h"
+#include "aggregate.h"
+#include "errors.h"
 int formatstoshow ;
 int verbose ;
-const int INBUFSZ = 2048 ;
+int mode ;
+long long membytes = 256LL << 20 ;
+int nthreads ;
+int packedio ;
+const char *features = "" ;
+struct ccWriter ccw ;
+#define INBUFSZ 2048
 char inbuffer[INBUFSZ] ;
-void error(const char *s) {
+__attribute__((noreturn)) void error(const char *s) {
    fprintf(stderr, "rubikconvert: %s\n", s) ;
    exit(10) ;
 }
+__attribute__((noreturn)) void failed(int err) {
+   fprintf(stderr, "Failed with error code %d\n", err) ;
+   exit(10) ;
+}
 struct cubecoords cc ;
+struct cubies cu ;
+struct phasecoords pc ;
 char reidbuf[INBUFSZ] ;
+char movebuf[3*BATCH_LINESZ] ;
 unsigned char buf1[100] ;
 unsigned char buf2[100] ;
-char *toks[54] ;
-int itoks[54] ;
-void toints(int n, int lo, int hi, int base) {
-   for (int i=0; i<n; i++) {
-      char *end ;
-      int v = strtol(toks[i], &end, base) ;
-      if (*end)
-         error("! bad parse of int") ;
-      if (v < lo || v >= hi)
-         error("! integer value out of range") ;
-      itoks[i] = v ;
+unsigned char stickerbuf[54] ;
+unsigned char kubebuf[54] ;
+/*
+ *   Show the current state (cu if havecubies, else cc, with the binary
+ *   form in buf1) in all the requested formats.
+ */
+void showstate(int havecubies) {
+   int err ;
+   // render all the requested text formats from a single decode
+   char *wantreid = (formatstoshow >> ('r'-'a')) & 1 ? reidbuf : 0 ;
+   unsigned char *wantstickers =
+                    (formatstoshow >> ('s'-'a')) & 1 ? stickerbuf : 0 ;
+   unsigned char *wantheykube =
+                    (formatstoshow >> ('h'-'a')) & 1 ? kubebuf : 0 ;
+   if (havecubies)
+      err = cubiesToFormats(&cu, wantreid, wantstickers, wantheykube) ;
+   else
+      err = componentsToFormats(&cc, wantreid, wantstickers, wantheykube) ;
+   if (err)
+      error("! error during output conversion") ;
+   for (int of='a'; of<='z'; of++) {
+      if ((formatstoshow >> (of-'a')) & 1) {
+         switch(of) {
+case 'b':
+            if (verbose)
+                printf("Binary: ") ;
+            for (int i=0; i<11; i++) {
+               if (i)
+                  printf(" ") ;
+               printf("%02x", buf1[i]) ;
+            }
+            printf("\n") ;
+            break ;
+case 'c':
+            if (verbose)
+                printf("Components: ") ;
+            printf("%d %d %d %d\n", cc.epLex, cc.eoMask, cc.cpLex,
+                                    cc.coMask) ;
+            break ;
+case 'k':
+            if (havecubies)
+               err = cubiesToPhase(&cu, &pc) ;
+            else
+               err = componentsToPhase(&cc, &pc) ;
+            if (err)
+               error("! error during output conversion") ;
+            if (verbose)
+                printf("Kociemba: ") ;
+            printf("%d %d %d %d %d %d\n", pc.twist, pc.flip, pc.slice,
+                   pc.cornerPerm, pc.udEdgePerm, pc.slicePerm) ;
+            break ;
+case 'r':
+            if (verbose)
+                printf("Reid: ") ;
+            printf("%s\n", reidbuf) ;
+            break ;
+case 'h':
+            if (verbose)
+                printf("Heycube: ") ;
+            for (int i=0; i<54; i++) {
+               if (i)
+                  printf(" ") ;
+               printf("%d", kubebuf[i]) ;
+            }
+            printf("\n") ;
+            break ;
+case 's':
+            if (verbose)
+                printf("Stickers: ") ;
+            for (int i=0; i<54; i++) {
+               if (i)
+                  printf(" ") ;
+               printf("%d", stickerbuf[i]) ;
+            }
+            printf("\n") ;
+            break ;
+default:
+            break ;
+         }
+      }
    }
 }
-int ismovestring(const char *a) {
-   return ((*a == 'U' || *a == 'F' || *a == 'R' ||
-            *a == 'D' || *a == 'B' || *a == 'L') &&
-           (a[1] == 0 || (a[2] == 0 && (a[1] == '2' || a[1] == '\'')))) ;
+/*
+ *   Copy packed 11-byte records from stdin into a container.
+ */
+#define COLBATCH 4096
+int cols[4][COLBATCH] ;
+unsigned char packed[11*COLBATCH] ;
+unsigned char errbits[COLBATCH/8] ;
+void packedtocontainer() {
+   size_t n ;
+   while ((n = fread(packed, 11, COLBATCH, stdin)) > 0) {
+      if (frombytes11Bulk(packed, n, cols[0], cols[1], cols[2], cols[3],
+                          errbits) != 0)
+         error("! bad binary record") ;
+      for (size_t i=0; i<n; i++) {
+         cc.epLex = cols[0][i] ;
+         cc.eoMask = cols[1][i] ;
+         cc.cpLex = cols[2][i] ;
+         cc.coMask = cols[3][i] ;
+         int err = ccWriterAdd(&ccw, &cc) ;
+         if (err)
+            failed(err) ;
+      }
+   }
+   int err = ccWriterClose(&ccw) ;
+   if (err)
+      failed(err) ;
+}
+/*
+ *   Read a container from stdin and show every state, or write them
+ *   as packed 11-byte records.
+ */
+void readcontainer() {
+   struct ccReader r ;
+   int err = ccReaderOpen(&r, stdin) ;
+   int n ;
+   cc.poIdxU = 7 ;
+   cc.poIdxL = cc.moSupport = cc.moMask = 0 ;
+   while (err == 0 &&
+          (n = ccReadBlock(&r, cols[0], cols[1], cols[2], cols[3])) != 0) {
+      if (n < 0) {
+         err = n ;
+         break ;
+      }
+      if (packedio) {
+         tobytes11Bulk(cols[0], cols[1], cols[2], cols[3], n, packed) ;
+         if (fwrite(packed, 11, n, stdout) != (size_t)n)
+            err = IO_ERROR ;
+         continue ;
+      }
+      for (int i=0; i<n; i++) {
+         cc.epLex = cols[0][i] ;
+         cc.eoMask = cols[1][i] ;
+         cc.cpLex = cols[2][i] ;
+         cc.coMask = cols[3][i] ;
+         tobytes11(&cc, buf1) ;
+         showstate(0) ;
+      }
+   }
+   ccReaderClose(&r) ;
+   if (err)
+      failed(err) ;
 }
 int main(int argc, char *argv[]) {
    while (argc > 1 && argv[1][0] == '-') {
@@ -57,138 +248,149 @@ case 'b': formatstoshow |= 1<<('b'-'a') ; break ;
 case 'c': formatstoshow |= 1<<('c'-'a') ; break ;
 case 's': formatstoshow |= 1<<('s'-'a') ; break ;
 case 'h': formatstoshow |= 1<<('h'-'a') ; break ;
+case 'k': formatstoshow |= 1<<('k'-'a') ; break ;
 case 'v': verbose = 1 ; break ;
+case 'S': mode = 'S' ; break ;
+case 'i': mode = 'i' ; break ;
+case 'V': mode = 'V' ; break ;
+case 'C': mode = 'C' ; break ;
+case 'X': mode = 'X' ; break ;
+case 'M': mode = 'M' ; break ;
+case 'A': mode = 'A' ; features = argv[0]+2 ; break ;
+case 'P': packedio = 1 ; break ;
+case 'm': membytes = atoll(argv[0]+2) << 20 ; break ;
+case 't': nthreads = atoi(argv[0]+2) ; break ;
       }
    }
+   if (mode == 'S' || mode == 'V') {
+      int err = mode == 'S' ? sortRecords11(stdin, stdout, membytes, nthreads)
+                            : verifySolutions(stdin, stdout, nthreads) ;
+      if (err != 0)
+         failed(err) ;
+      return 0 ;
+   }
+   if (mode == 'M') {
+      struct lineBatch lines ;
+      int err = lineBatchInit(&lines) ;
+      while (err == 0) {
+         err = lineBatchRead(stdin, &lines) ;
+         if (err || lines.n == 0)
+            break ;
+         for (int i=0; i<lines.n; i++) {
+            int r = lines.status[i] ;
+            if (r == 0)
+               r = simplifyMoves(lines.arena + lines.start[i], movebuf,
+                                 sizeof(movebuf)) ;
+            if (r < 0)
+               printf("error %d\n", r) ;
+            else
+               printf("%s\n", movebuf) ;
+         }
+      }
+      lineBatchFree(&lines) ;
+      if (err != 0)
+         failed(err) ;
+      return 0 ;
+   }
+   if (mode == 'A') {
+      int mask = aggFeatureMask(features) ;
+      if (mask < 0)
+         error("! unknown feature name") ;
+      int err = aggregateStates(stdin, stdout, mask, packedio, nthreads) ;
+      if (err != 0)
+         failed(err) ;
+      return 0 ;
+   }
    if (formatstoshow == 0) {
       verbose = 1 ;
-      formatstoshow = -1 ; // show everything
+      formatstoshow = ~(1<<('k'-'a')) ; // show all the state formats
+   }
+   if (mode == 'X') {
+      readcontainer() ;
+      return 0 ;
+   }
+   if (mode == 'C') {
+      int err = ccWriterOpen(&ccw, stdout) ;
+      if (err)
+         failed(err) ;
+      if (packedio) {
+         packedtocontainer() ;
+         return 0 ;
+      }
    }
+   // without binary or component output we never need to rank
+   int direct = mode == 'i' || (mode != 'C' &&
+                !(formatstoshow & ((1<<('b'-'a')) | (1<<('c'-'a'))))) ;
+   perm prevstate ;
+   int haveprev = 0 ;
    while (fgets(inbuffer, INBUFSZ-1, stdin)) {
-      // let's try to figure out what we got.  how many tokens?
-      int ntoks = 0 ;
-      int intok = 0 ;
       char *q = inbuffer + strlen(inbuffer) - 1 ;
-      while (q >= inbuffer && *q <= ' ') // clear trailing whitespace
-         *q-- = 0 ;
-      strcpy(reidbuf, inbuffer) ; // keep a copy; we're about to trash inbuffer
-      for (char *p = inbuffer; *p; p++) {
-         if (*p <= ' ') {
-            if (intok) {
-               *p = 0 ;
-               intok = 0 ;
-            }
-         } else {
-            if (!intok) {
-               if (ntoks > 54)
-                  error("! too many tokens") ;
-               toks[ntoks++] = p ;
-               intok = 1 ;
-            }
+      int toolong = 0 ;
+      if (mode == 'i' && q >= inbuffer && *q != '\n') {
+         int c = getc(stdin) ; // a newline or the end here means it fit
+         if (c != EOF && c != '\n') {
+            while ((c = getc(stdin)) != EOF && c != '\n')
+               ;
+            toolong = 1 ;
          }
       }
-      int err = 0 ;
-      if (ntoks == 0 || ismovestring(toks[0])) {
-         perm p ;
-         iota(p) ;
-         err = domoves(p, reidbuf) ;
-         if (err == 0)
-            err = heykubeToComponents(p, &cc) ;
-      } else if (ntoks == 4) { // has to be 4-valued coordinate values
-         toints(ntoks, 0, 500000000, 10) ;
-         cc.epLex = itoks[0] ;
-         cc.eoMask = itoks[1] ;
-         cc.cpLex = itoks[2] ;
-         cc.coMask = itoks[3] ;
-         cc.poIdxU = 7 ;
-         cc.poIdxL = cc.moSupport = cc.moMask = 0 ;
-      } else if (ntoks == 11) { // has to be 11-byte hex
-         toints(ntoks, 0, 256, 16) ;
-         for (int i=0; i<11; i++)
-            buf1[i] = itoks[i] ;
-         err = frombytes11(buf1, &cc) ;
-      } else if (ntoks == 20) { // has to be reid
-         err = ReidToComponents(reidbuf, &cc) ;
-      } else if (ntoks == 54) { // only stickers and hexcube are left.
-         toints(ntoks, 0, 54, 10) ;
-         int hival = 0 ;
-         for (int i=0; i<54; i++) {
-            if (itoks[i] > hival)
-               hival = itoks[i] ;
-            buf1[i] = itoks[i] ;
-         }
-         if (hival == 5) {
-            err = stickersToComponents(buf1, &cc) ;
-         } else if (hival == 53) {
-            err = heykubeToComponents(buf1, &cc) ;
-         } else {
-            error("! bad stickers or permutation values") ;
+      while (q >= inbuffer && *q <= ' ') // clear trailing whitespace
+         *q-- = 0 ;
+      int havecubies = 0 ;
+      int err = toolong ? LINE_TOO_LONG :
+                          parseState(inbuffer, &cu, &cc, &havecubies) ;
+      if (mode != 'i') // telemetry reports bad samples below instead
+         switch (err) {
+case BAD_INTEGER: error("! bad parse of int") ;
+case INTEGER_OUT_OF_RANGE: error("! integer value out of range") ;
+case TOO_MANY_TOKENS: error("! too many tokens") ;
+case BAD_STICKER_VALUES: error("! bad stickers or permutation values") ;
+case BAD_TOKEN_COUNT: error("! bad number of tokens on a line") ;
+default: break ;
          }
-      } else {
-         error("! bad number of tokens on a line") ;
+      if (err == 0 && havecubies) {
+         if (direct)
+            err = checkCubies(&cu) ;
+         else
+            err = cubiesToComponents(&cu, &cc) ;
       }
-      if (err == 0) {
+      if (err == 0 && !(direct && havecubies)) {
          tobytes11(&cc, buf1) ;
          err = frombytes11(buf1, &cc) ; // use error checking here
       }
-      if (err != 0) {
-         fprintf(stderr, "Failed with error code %d\n", err) ;
-         exit(10) ;
+      if (err != 0 && mode == 'i') {
+         printf("error %d\n", err) ;
+         haveprev = 0 ;
+         continue ;
       }
-      for (int of='a'; of<='z'; of++) {
-         if ((formatstoshow >> (of-'a')) & 1) {
-            err = 0 ;
-            switch(of) {
-case 'b':
-               if (verbose)
-                   printf("Binary: ") ;
-               for (int i=0; i<11; i++) {
-                  if (i)
-                     printf(" ") ;
-                  printf("%02x", buf1[i]) ;
-               }
-               printf("\n") ;
-               break ;
-case 'c':
-               if (verbose)
-                   printf("Components: ") ;
-               printf("%d %d %d %d\n", cc.epLex, cc.eoMask, cc.cpLex,
-                                       cc.coMask) ;
-               break ;
-case 'r':
-               err = componentsToReid(&cc, reidbuf) ;
-               if (verbose)
-                   printf("Reid: ") ;
-               printf("%s\n", reidbuf) ;
-               break ;
-case 'h':
-               if (verbose)
-                   printf("Heycube: ") ;
-               err = componentsToHeykube(&cc, buf1) ;
-               for (int i=0; i<54; i++) {
-                  if (i)
-                     printf(" ") ;
-                  printf("%d", buf1[i]) ;
-               }
-               printf("\n") ;
-               break ;
-case 's':
-               if (verbose)
-                   printf("Stickers: ") ;
-               err = componentsToStickers(&cc, buf1) ;
-               for (int i=0; i<54; i++) {
-                  if (i)
-                     printf(" ") ;
-                  printf("%d", buf1[i]) ;
-               }
-               printf("\n") ;
-               break ;
-default:
-               break ;
-            }
-            if (err)
-               error("! error during output conversion") ;
+      if (err != 0)
+         failed(err) ;
+      if (mode == 'i') {
+         perm p ;
+         if (havecubies)
+            cubiesToHeykube(&cu, p) ;
+         else
+            componentsToHeykube(&cc, p) ;
+         if (haveprev) {
+            if (inferMoves(prevstate, p, reidbuf) < 0)
+               strcpy(reidbuf, "gap") ;
+            printf("%s\n", reidbuf) ;
          }
+         memcpy(prevstate, p, sizeof(perm)) ;
+         haveprev = 1 ;
+         continue ;
       }
+      if (mode == 'C') {
+         err = ccWriterAdd(&ccw, &cc) ;
+         if (err)
+            failed(err) ;
+         continue ;
+      }
+      showstate(havecubies) ;
+   }
+   if (mode == 'C') {
+      int err = ccWriterClose(&ccw) ;
+      if (err)
+         failed(err) ;
    }
 }
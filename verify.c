@@ -0,0 +1,108 @@
+/**
+ *   Check proposed solutions in bulk.
+ *
+ *   Each line is a state in any input format, a vertical bar, and a
+ *   move sequence:
+ *
+ *      UF UR UB UL DF DR DB DL FR FL BR BL URB UBL ULF UFR ... | U'
+ *
+ *   The moves are applied to the cubie form, twenty bytes a move
+ *   rather than a 54-element permutation, and the result compared
+ *   with the solved cube.  Lines are read a batch at a time and split
+ *   among threads, and results are written in input order, so memory
+ *   use stays constant however long the stream is.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "cubecoords.h"
+#include "moves.h"
+#include "parsestate.h"
+#include "batch.h"
+#include "verify.h"
+#include "errors.h"
+/*
+ *   Verify one line.  Returns 1 if the moves solve the state, 0 if
+ *   not, or an error; the number of moves is returned in *length.
+ */
+int verifySolution(const char *line, int *length) {
+   char state[BATCH_LINESZ] ;
+   const char *bar = strchr(line, '|') ;
+   *length = 0 ;
+   if (bar == 0)
+      return MISSING_SOLUTION ;
+   if (bar - line >= BATCH_LINESZ)
+      return LINE_TOO_LONG ;
+   memcpy(state, line, bar - line) ;
+   state[bar - line] = 0 ;
+   struct cubies cu ;
+   struct cubecoords cc ;
+   int havecubies ;
+   int err = parseState(state, &cu, &cc, &havecubies) ;
+   if (err == 0 && !havecubies)
+      err = componentsToCubies(&cc, &cu) ;
+   if (err)
+      return err ;
+   int n = domovesCubies(&cu, bar+1) ;
+   if (n < 0)
+      return n ;
+   *length = n ;
+   for (int i=0; i<12; i++)
+      if (cu.e[i] != 2*i)
+         return 0 ;
+   for (int i=0; i<8; i++)
+      if (cu.c[i] != 4*i)
+         return 0 ;
+   return 1 ;
+}
+/*
+ *   One batch of lines, shared by the threads.
+ */
+struct verifyBatch {
+   struct lineBatch lines ;
+   int *result ;
+   int *length ;
+} ;
+static void verifySlice(void *arg, int t, int nt) {
+   struct verifyBatch *b = arg ;
+   int lo = (long long)b->lines.n * t / nt ;
+   int hi = (long long)b->lines.n * (t + 1) / nt ;
+   for (int i=lo; i<hi; i++) {
+      b->length[i] = 0 ;
+      b->result[i] = b->lines.status[i] ? b->lines.status[i] :
+                     verifySolution(b->lines.arena + b->lines.start[i],
+                                    &b->length[i]) ;
+   }
+}
+/*
+ *   Read lines from in and write one result line per input line to
+ *   out:  "pass <moves>", "fail <moves>", or "error <code>".
+ */
+int verifySolutions(FILE *in, FILE *out, int nthreads) {
+   nthreads = threadCount(nthreads) ;
+   initmoves() ; // before any threads use the move tables
+   struct verifyBatch b ;
+   int err = lineBatchInit(&b.lines) ;
+   b.result = malloc(BATCH_LINES * sizeof(int)) ;
+   b.length = malloc(BATCH_LINES * sizeof(int)) ;
+   if (err == 0 && (b.result == 0 || b.length == 0))
+      err = OUT_OF_MEMORY ;
+   while (err == 0) {
+      err = lineBatchRead(in, &b.lines) ;
+      if (err || b.lines.n == 0)
+         break ;
+      runThreads(b.lines.n < 256 ? 1 : nthreads, verifySlice, &b) ;
+      for (int i=0; i<b.lines.n; i++)
+         if (b.result[i] < 0)
+            fprintf(out, "error %d\n", b.result[i]) ;
+         else
+            fprintf(out, "%s %d\n", b.result[i] ? "pass" : "fail",
+                    b.length[i]) ;
+   }
+   lineBatchFree(&b.lines) ;
+   free(b.result) ;
+   free(b.length) ;
+   if (err == 0 && fflush(out) != 0)
+      err = IO_ERROR ;
+   return err ;
+}
@@ -0,0 +1,9 @@
+/*
+ *   Routines exported.
+ */
+#ifndef VERIFY_H
+#include <stdio.h>
+extern int verifySolution(const char *line, int *length) ;
+extern int verifySolutions(FILE *in, FILE *out, int nthreads) ;
+#define VERIFY_H
+#endif